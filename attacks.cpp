@@ -0,0 +1,254 @@
+#include "attacks.h"
+#include "bitboard.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define ATTACKS_X86 1
+#endif
+
+namespace {
+
+constexpr Bitboard NOT_FILE_A = ~0x0101010101010101ULL;
+constexpr Bitboard NOT_FILE_H = ~0x8080808080808080ULL;
+
+void slider_attacks_scalar(const Bitboard* sliders, int count, Bitboard occ, bool diagonal, Bitboard* out) {
+    for (int i = 0; i < count; i++) {
+        if (!sliders[i]) {
+            out[i] = 0;
+            continue;
+        }
+        const int sq = lsb(sliders[i]);
+        out[i] = diagonal ? get_bishop_attacks(sq, occ) : get_rook_attacks(sq, occ);
+    }
+}
+
+#ifdef ATTACKS_X86
+// Kogge-Stone occluded fill of four sliders, one per 64-bit lane. `pro` holds the empty
+// squares (minus the wrap-around file for sideways directions); the fill includes the
+// sliders themselves, so the attacks are the fill shifted one more step under the same mask.
+template <int S>
+__attribute__((target("avx2")))
+inline __m256i fill_up(__m256i gen, __m256i pro) {
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_slli_epi64(gen, S)));
+    pro = _mm256_and_si256(pro, _mm256_slli_epi64(pro, S));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_slli_epi64(gen, 2 * S)));
+    pro = _mm256_and_si256(pro, _mm256_slli_epi64(pro, 2 * S));
+    return _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_slli_epi64(gen, 4 * S)));
+}
+
+template <int S>
+__attribute__((target("avx2")))
+inline __m256i fill_down(__m256i gen, __m256i pro) {
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_srli_epi64(gen, S)));
+    pro = _mm256_and_si256(pro, _mm256_srli_epi64(pro, S));
+    gen = _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_srli_epi64(gen, 2 * S)));
+    pro = _mm256_and_si256(pro, _mm256_srli_epi64(pro, 2 * S));
+    return _mm256_or_si256(gen, _mm256_and_si256(pro, _mm256_srli_epi64(gen, 4 * S)));
+}
+
+// Direction pairs: +S with `upMask` guarding the wrap, -S with `downMask`.
+template <int S>
+__attribute__((target("avx2")))
+inline __m256i ray_pair(__m256i gen, __m256i empty, __m256i upMask, __m256i downMask) {
+    const __m256i up = fill_up<S>(gen, _mm256_and_si256(empty, upMask));
+    const __m256i down = fill_down<S>(gen, _mm256_and_si256(empty, downMask));
+    return _mm256_or_si256(_mm256_and_si256(_mm256_slli_epi64(up, S), upMask),
+                           _mm256_and_si256(_mm256_srli_epi64(down, S), downMask));
+}
+
+__attribute__((target("avx2")))
+void slider_attacks_avx2(const Bitboard* sliders, int count, Bitboard occ, bool diagonal, Bitboard* out) {
+    const __m256i empty = _mm256_set1_epi64x(static_cast<long long>(~occ));
+    const __m256i all = _mm256_set1_epi64x(-1);
+    const __m256i notA = _mm256_set1_epi64x(static_cast<long long>(NOT_FILE_A));
+    const __m256i notH = _mm256_set1_epi64x(static_cast<long long>(NOT_FILE_H));
+
+    for (int i = 0; i < count; i += 4) {
+        const __m256i gen = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sliders + i));
+
+        __m256i attacks;
+        if (diagonal) {
+            // Up 9 (north-east) and down 9 (south-west), up 7 (north-west) and down 7 (south-east)
+            attacks = _mm256_or_si256(ray_pair<9>(gen, empty, notA, notH), ray_pair<7>(gen, empty, notH, notA));
+        } else {
+            attacks = _mm256_or_si256(ray_pair<8>(gen, empty, all, all), ray_pair<1>(gen, empty, notA, notH));
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), attacks);
+    }
+}
+#endif
+
+using SliderAttacksFn = void (*)(const Bitboard*, int, Bitboard, bool, Bitboard*);
+
+SliderAttacksFn select_slider_attacks() {
+#ifdef ATTACKS_X86
+    __builtin_cpu_init(); // Runs during static initialisation
+    if (__builtin_cpu_supports("avx2")) return slider_attacks_avx2;
+#endif
+    return slider_attacks_scalar;
+}
+
+const SliderAttacksFn slider_attacks_impl = select_slider_attacks();
+
+Bitboard pawn_attack_span(Bitboard pawns, int c) {
+    if (c == WHITE) return ((pawns & NOT_FILE_A) << 7) | ((pawns & NOT_FILE_H) << 9);
+    return ((pawns & NOT_FILE_A) >> 9) | ((pawns & NOT_FILE_H) >> 7);
+}
+
+} // namespace
+
+void slider_attacks(const Bitboard* sliders, int count, Bitboard occ, bool diagonal, Bitboard* out) {
+    slider_attacks_impl(sliders, count, occ, diagonal, out);
+}
+
+const char* slider_kernel_name() {
+    return slider_attacks_impl == slider_attacks_scalar ? "scalar" : "avx2";
+}
+
+void compute_attack_maps(const Board& board, AttackMaps& maps) {
+    const Bitboard occ = board.color[WHITE] | board.color[BLACK];
+
+    // One kernel batch per slider direction set: queens go into both, listed first
+    // for each colour so that they line up in the two outputs
+    Bitboard diagGen[SLIDER_BATCH_SIZE], orthoGen[SLIDER_BATCH_SIZE];
+    int diagCount = 0, orthoCount = 0;
+    auto collect = [&](Bitboard bb, Bitboard* gen, int& n) {
+        int k = 0;
+        for (; bb; bb &= bb - 1, k++) gen[n++] = bb & -bb;
+        return k;
+    };
+    for (int c = WHITE; c <= BLACK; c++) {
+        const Bitboard ours = board.color[c];
+        const Bitboard queens = board.piece[QUEEN - 1] & ours;
+        maps.count[c][QUEEN] = static_cast<uint8_t>(collect(queens, diagGen, diagCount));
+        collect(queens, orthoGen, orthoCount);
+        maps.count[c][BISHOP] = static_cast<uint8_t>(collect(board.piece[BISHOP - 1] & ours, diagGen, diagCount));
+        maps.count[c][ROOK] = static_cast<uint8_t>(collect(board.piece[ROOK - 1] & ours, orthoGen, orthoCount));
+    }
+    while (diagCount & 3) diagGen[diagCount++] = 0;
+    while (orthoCount & 3) orthoGen[orthoCount++] = 0;
+
+    Bitboard diag[SLIDER_BATCH_SIZE], ortho[SLIDER_BATCH_SIZE];
+    slider_attacks(diagGen, diagCount, occ, true, diag);
+    slider_attacks(orthoGen, orthoCount, occ, false, ortho);
+
+    int d = 0, o = 0;
+    for (int c = WHITE; c <= BLACK; c++) {
+        Bitboard all, pieceAll;
+
+        pieceAll = 0;
+        for (int k = 0; k < maps.count[c][QUEEN]; k++) pieceAll |= maps.pieces[c][QUEEN][k] = diag[d++] | ortho[o++];
+        maps.byType[c][QUEEN] = all = pieceAll;
+
+        pieceAll = 0;
+        for (int k = 0; k < maps.count[c][BISHOP]; k++) pieceAll |= maps.pieces[c][BISHOP][k] = diag[d++];
+        maps.byType[c][BISHOP] = pieceAll;
+        all |= pieceAll;
+
+        pieceAll = 0;
+        for (int k = 0; k < maps.count[c][ROOK]; k++) pieceAll |= maps.pieces[c][ROOK][k] = ortho[o++];
+        maps.byType[c][ROOK] = pieceAll;
+        all |= pieceAll;
+
+        pieceAll = 0;
+        int k = 0;
+        for (Bitboard bb = board.piece[KNIGHT - 1] & board.color[c]; bb; bb &= bb - 1, k++) {
+            pieceAll |= maps.pieces[c][KNIGHT][k] = knight_attacks[lsb(bb)];
+        }
+        maps.count[c][KNIGHT] = static_cast<uint8_t>(k);
+        maps.byType[c][KNIGHT] = pieceAll;
+        all |= pieceAll;
+
+        const Bitboard king = board.piece[KING - 1] & board.color[c];
+        maps.byType[c][PAWN] = pawn_attack_span(board.piece[PAWN - 1] & board.color[c], c);
+        maps.byType[c][KING] = king ? king_attacks[lsb(king)] : 0;
+        maps.byType[c][0] = all | maps.byType[c][PAWN] | maps.byType[c][KING];
+    }
+}
+
+void compute_attack_info(const Board& board, AttackInfo& info) {
+    info.us = side_to_move(board);
+    info.them = other_color(info.us);
+    info.own = board.color[info.us];
+    info.opp = board.color[info.them];
+    info.occ = info.own | info.opp;
+    compute_attack_maps(board, info.maps);
+
+    const Bitboard king = board.piece[KING - 1] & info.own;
+    info.kingSq = king ? lsb(king) : 0;
+    info.checkers = king ? attackers_to(board, info.kingSq, info.occ) & info.opp : 0ULL;
+
+    // Pins: enemy sliders that would attack the king with only our pieces removed.
+    info.pinned = 0ULL;
+    if (king) {
+        const Bitboard enemyDiag = (board.piece[BISHOP - 1] | board.piece[QUEEN - 1]) & info.opp;
+        const Bitboard enemyOrtho = (board.piece[ROOK - 1] | board.piece[QUEEN - 1]) & info.opp;
+        Bitboard snipers = (get_bishop_attacks(info.kingSq, info.opp) & enemyDiag) |
+                           (get_rook_attacks(info.kingSq, info.opp) & enemyOrtho);
+        while (snipers) {
+            const int sniperSq = lsb(snipers);
+            snipers &= snipers - 1;
+            const Bitboard blockers = between_bb[info.kingSq][sniperSq] & info.occ;
+            if (blockers && !(blockers & (blockers - 1)) && (blockers & info.own)) {
+                info.pinned |= blockers;
+            }
+        }
+    }
+
+    if (info.checkers == 0) {
+        info.checkMask = ~0ULL;
+    } else if (!(info.checkers & (info.checkers - 1))) {
+        info.checkMask = info.checkers | between_bb[info.kingSq][lsb(info.checkers)];
+    } else {
+        info.checkMask = 0ULL; // Double check: only the king may move
+    }
+
+    // The enemy attack map stops at our king; a slider checking it also covers the square
+    // behind, so the king cannot step back along the checking ray.
+    info.kingDanger = info.maps.byType[info.them][0];
+    const Bitboard sliders = info.checkers & ~board.piece[PAWN - 1] & ~board.piece[KNIGHT - 1];
+    for (Bitboard bb = sliders; bb; bb &= bb - 1) {
+        const int sq = lsb(bb);
+        info.kingDanger |= line_bb[info.kingSq][sq] & king_attacks[info.kingSq] & ~(1ULL << sq);
+    }
+}
+
+bool gives_check(const Board& board, const Move& move) {
+    const int us = side_to_move(board);
+    const Bitboard ours = board.color[us];
+    const Bitboard enemyKing = board.piece[KING - 1] & board.color[other_color(us)];
+    if (!enemyKing) return false;
+    const int ksq = lsb(enemyKing);
+
+    const int from = move.from_sq();
+    const int to = move.to_sq();
+    Bitboard moved = 1ULL << from; // Our pieces leaving their squares
+    Bitboard occ = ((ours | board.color[other_color(us)]) & ~moved) | (1ULL << to);
+    if (move.is_en_passant()) occ &= ~(1ULL << (us == WHITE ? to - 8 : to + 8));
+
+    // Direct check by the piece on its new square; for castling that piece is the rook
+    int type = move.promotion() ? move.promotion() : piece_type(piece_at_sq(board, from));
+    int sq = to;
+    if (move.is_castling()) {
+        const int rookFrom = to > from ? from + 3 : from - 4;
+        type = ROOK;
+        sq = to > from ? to - 1 : to + 1;
+        moved |= 1ULL << rookFrom;
+        occ = (occ & ~(1ULL << rookFrom)) | (1ULL << sq);
+    }
+    const Bitboard kingBB = 1ULL << ksq;
+    switch (type) {
+        case PAWN:   if (pawn_attacks[us][sq] & kingBB) return true; break;
+        case KNIGHT: if (knight_attacks[sq] & kingBB) return true; break;
+        case BISHOP: if (get_bishop_attacks(sq, occ) & kingBB) return true; break;
+        case ROOK:   if (get_rook_attacks(sq, occ) & kingBB) return true; break;
+        case QUEEN:  if ((get_bishop_attacks(sq, occ) | get_rook_attacks(sq, occ)) & kingBB) return true; break;
+        default: break;
+    }
+
+    // Discovered check by a slider that stayed put
+    const Bitboard stayed = ours & ~moved;
+    const Bitboard diag = (board.piece[BISHOP - 1] | board.piece[QUEEN - 1]) & stayed;
+    const Bitboard ortho = (board.piece[ROOK - 1] | board.piece[QUEEN - 1]) & stayed;
+    return (get_bishop_attacks(ksq, occ) & diag) || (get_rook_attacks(ksq, occ) & ortho);
+}
@@ -0,0 +1,68 @@
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#include "board.h"
+#include "bitboard.h"
+
+// Ten of one piece type is the most a side can have (two originals plus eight promotions)
+inline constexpr int MAX_PER_TYPE = 10;
+
+// Per-side attack maps of one position, built in a single pass for the evaluation.
+struct AttackMaps {
+    Bitboard byType[2][KING + 1];                 // [colour][piece type]; [c][0] is everything c attacks
+    Bitboard pieces[2][KING + 1][MAX_PER_TYPE];   // Attacks of each knight, bishop, rook and queen
+    uint8_t count[2][KING + 1];                   // Valid entries in pieces[c][type]
+};
+
+void compute_attack_maps(const Board& board, AttackMaps& maps);
+
+// Everything about attacks in one position, computed once per node and shared by move
+// generation, legality checks, check detection and the evaluation. The legality fields
+// are from the side to move's point of view.
+struct AttackInfo {
+    int us, them;
+    int kingSq;
+    Bitboard own, opp, occ;
+    Bitboard checkers;     // Enemy pieces giving check
+    Bitboard pinned;       // Our pieces pinned to our king
+    Bitboard checkMask;    // Non-king moves must land here (everything when not in check)
+    Bitboard kingDanger;   // Squares attacked by the enemy, seen through our king
+    AttackMaps maps;
+
+    bool in_check() const { return checkers != 0; }
+};
+
+void compute_attack_info(const Board& board, AttackInfo& info);
+
+// Pieces of both colours attacking `sq`, with sliders seeing through `occ`.
+inline Bitboard attackers_to(const Board& board, int sq, Bitboard occ) {
+    return (pawn_attacks[BLACK][sq] & board.piece[PAWN - 1] & board.color[WHITE]) |
+           (pawn_attacks[WHITE][sq] & board.piece[PAWN - 1] & board.color[BLACK]) |
+           (knight_attacks[sq] & board.piece[KNIGHT - 1]) |
+           (king_attacks[sq] & board.piece[KING - 1]) |
+           (get_bishop_attacks(sq, occ) & (board.piece[BISHOP - 1] | board.piece[QUEEN - 1])) |
+           (get_rook_attacks(sq, occ) & (board.piece[ROOK - 1] | board.piece[QUEEN - 1]));
+}
+
+// Does the pseudo-legal `move` check the enemy king, directly or by discovery?
+bool gives_check(const Board& board, const Move& move);
+
+// Is the side to move in check? For nodes that may not need a full AttackInfo.
+inline bool is_in_check(const Board& board) {
+    const int us = side_to_move(board);
+    const Bitboard king = board.piece[KING - 1] & board.color[us];
+    return king && (attackers_to(board, lsb(king), board.color[WHITE] | board.color[BLACK]) & board.color[other_color(us)]);
+}
+
+// Room for every queen plus the bishops (or rooks) of both sides, padded to whole vectors
+inline constexpr int SLIDER_BATCH_SIZE = 2 * 2 * MAX_PER_TYPE + 4;
+
+// Attacks of `count` sliders (one-bit boards) moving along diagonals, or ranks and files,
+// through `occ`; out[i] belongs to sliders[i]. Both arrays must hold `count` rounded up
+// to a multiple of four; zero padding slots yield no attacks. Runs the AVX2 fill kernel
+// when the CPU has it, magic lookups otherwise.
+void slider_attacks(const Bitboard* sliders, int count, Bitboard occ, bool diagonal, Bitboard* out);
+
+const char* slider_kernel_name(); // "avx2" or "scalar"
+
+#endif
@@ -93,6 +93,8 @@ U64 bishop_masks[64];
 U64 rook_masks[64];
 U64 bishop_attacks[64][512];
 U64 rook_attacks[64][4096];
+U64 between_bb[64][64];
+U64 line_bb[64][64];
 
 // Relevant occupancy bits
 const int bishop_relevant_bits[64] = {
@@ -235,10 +237,32 @@ void init_slider_attacks(int bishop) {
     }
 }
 
+// Squares between / on the line through two aligned squares (empty when not aligned)
+void init_line_tables() {
+    for (int s1 = 0; s1 < 64; s1++) {
+        for (int s2 = 0; s2 < 64; s2++) {
+            between_bb[s1][s2] = 0ULL;
+            line_bb[s1][s2] = 0ULL;
+            if (s1 == s2) continue;
+
+            U64 b1 = 1ULL << s1;
+            U64 b2 = 1ULL << s2;
+            if (rook_attacks_on_the_fly(s1, 0ULL) & b2) {
+                line_bb[s1][s2] = (rook_attacks_on_the_fly(s1, 0ULL) & rook_attacks_on_the_fly(s2, 0ULL)) | b1 | b2;
+                between_bb[s1][s2] = rook_attacks_on_the_fly(s1, b2) & rook_attacks_on_the_fly(s2, b1);
+            } else if (bishop_attacks_on_the_fly(s1, 0ULL) & b2) {
+                line_bb[s1][s2] = (bishop_attacks_on_the_fly(s1, 0ULL) & bishop_attacks_on_the_fly(s2, 0ULL)) | b1 | b2;
+                between_bb[s1][s2] = bishop_attacks_on_the_fly(s1, b2) & bishop_attacks_on_the_fly(s2, b1);
+            }
+        }
+    }
+}
+
 void init_all() {
     init_leapers_attack();
     init_slider_attacks(BISHOP);
     init_slider_attacks(ROOK);
+    init_line_tables();
     init_char_pieces();
     // init_magic_numbers();
 }
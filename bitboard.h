@@ -18,6 +18,8 @@ void init_bitboards();
 extern U64 pawn_attacks[2][64]; // [2 colors][64 squares]
 extern U64 knight_attacks[64];
 extern U64 king_attacks[64];
+extern U64 between_bb[64][64]; // Squares strictly between two aligned squares
+extern U64 line_bb[64][64];    // Full rank/file/diagonal through two aligned squares
 
 U64 get_rook_attacks(int square, U64 occupancy);
 U64 get_bishop_attacks(int square, U64 occupancy);
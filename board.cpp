@@ -1,9 +1,27 @@
 #include "board.h"
 #include "bitboard.h"
+#include "evaluation.h"
+#include "attacks.h"
 #include <algorithm>
+#include <cassert>
 #include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
 
 char columns[] = "abcdefgh";
 
@@ -28,6 +46,7 @@ inline Bitboard bit_at_sq(int sq) {
     return 1ULL << sq;
 }
 
+// Bitboard updates also keep the incremental evaluation terms in step.
 inline void bb_clear(Board& board, int piece, int sq) {
     if (piece == 0) return;
     int idx = piece_type(piece) - 1;
@@ -35,6 +54,9 @@ inline void bb_clear(Board& board, int piece, int sq) {
     Bitboard mask = bit_at_sq(sq);
     board.piece[idx] &= ~mask;
     board.color[c] &= ~mask;
+    board.psqtScore -= psqt_table[piece][sq];
+    board.pieces_otb[piece]--;
+    board.materialKey ^= zobrist().material[piece][board.pieces_otb[piece]];
 }
 
 inline void bb_set(Board& board, int piece, int sq) {
@@ -44,6 +66,22 @@ inline void bb_set(Board& board, int piece, int sq) {
     Bitboard mask = bit_at_sq(sq);
     board.piece[idx] |= mask;
     board.color[c] |= mask;
+    board.psqtScore += psqt_table[piece][sq];
+    board.materialKey ^= zobrist().material[piece][board.pieces_otb[piece]];
+    board.pieces_otb[piece]++;
+}
+
+// Recompute the incremental evaluation terms from the mailbox.
+inline void refresh_eval_state(Board& board) {
+    board.psqtScore = 0;
+    for (int& count : board.pieces_otb) count = 0;
+    for (int sq = 0; sq < 64; ++sq) {
+        const int p = board.mailbox[sq];
+        if (p == 0) continue;
+        board.psqtScore += psqt_table[p][sq];
+        board.pieces_otb[p]++;
+    }
+    board.materialKey = material_key(board);
 }
 
 inline void set_start_position(Board& board) {
@@ -87,14 +125,35 @@ inline bool is_pawn_attack_possible(const Board& board, bool attackerIsWhite, in
     }
     return (pawn_attacks[WHITE][epSq] & pawns) != 0;
 }
-} // namespace
 
-Move::Move()
-    : fromRow(0), fromCol(0), toRow(0), toCol(0), capturedPiece(0), promotion(0), pieceType(0),
-      prevW_KingSide(false), prevW_QueenSide(false), prevB_KingSide(false), prevB_QueenSide(false),
-      prevEnPassantCol(-1), prevHalfMoveClock(0), isEnPassant(false), isCastling(false) {}
+inline int castling_rights(const Board& board) {
+    return (board.whiteCanCastleKingSide ? 1 : 0) | (board.whiteCanCastleQueenSide ? 2 : 0) |
+           (board.blackCanCastleKingSide ? 4 : 0) | (board.blackCanCastleQueenSide ? 8 : 0);
+}
+
+inline void set_castling_rights(Board& board, int rights) {
+    board.whiteCanCastleKingSide = rights & 1;
+    board.whiteCanCastleQueenSide = rights & 2;
+    board.blackCanCastleKingSide = rights & 4;
+    board.blackCanCastleQueenSide = rights & 8;
+}
+
+// Anything leaving or landing on a king or rook home square clears the matching rights.
+inline void drop_castling_rights(Board& board, int sq) {
+    switch (sq) {
+        case 0:  board.whiteCanCastleQueenSide = false; break;
+        case 4:  board.whiteCanCastleKingSide = board.whiteCanCastleQueenSide = false; break;
+        case 7:  board.whiteCanCastleKingSide = false; break;
+        case 56: board.blackCanCastleQueenSide = false; break;
+        case 60: board.blackCanCastleKingSide = board.blackCanCastleQueenSide = false; break;
+        case 63: board.blackCanCastleKingSide = false; break;
+        default: break;
+    }
+}
+} // namespace
 
 Board::Board() {
+    states.reserve(256);
     resetBoard();
 }
 
@@ -108,286 +167,180 @@ void Board::resetBoard() {
     isWhiteTurn = true;
     enPassantCol = -1;
     halfMoveClock = 0;
-    whiteKingRow = 7; whiteKingCol = 4;
-    blackKingRow = 0; blackKingCol = 4;
+    states.clear();
 
+    refresh_eval_state(*this);
+    nnue_refresh(*this);
     currentHash = position_key(*this);
+    pawnKey = pawn_key(*this);
 }
 
-void Board::makeMove(Move& move) {
+void Board::makeMove(Move move) {
     const Zobrist& z = zobrist();
 
-    move.prevW_KingSide = whiteCanCastleKingSide;
-    move.prevW_QueenSide = whiteCanCastleQueenSide;
-    move.prevB_KingSide = blackCanCastleKingSide;
-    move.prevB_QueenSide = blackCanCastleQueenSide;
-    move.prevEnPassantCol = enPassantCol;
-    move.prevHalfMoveClock = halfMoveClock;
-
-    move.isEnPassant = false;
-    move.isCastling = false;
-
     const int fromSq = move.from_sq();
     const int toSq = move.to_sq();
+    const MoveType type = move.type();
     const int movingPiece = mailbox[fromSq];
-    int target_piece = mailbox[toSq];
+    const int us = piece_color(movingPiece);
+    const int capturedSq = (type == MOVE_EN_PASSANT) ? (fromSq & 56) | (toSq & 7) : toSq;
+    const int capturedPiece = mailbox[capturedSq];
+
+    states.push_back({move, capturedPiece, castling_rights(*this), enPassantCol, halfMoveClock, currentHash, pawnKey});
 
-    move.capturedPiece = target_piece;
-    
     // Update 50-move clock: reset on pawn move or capture, otherwise increment
-    if (piece_type(movingPiece) == PAWN || target_piece != 0) {
+    if (piece_type(movingPiece) == PAWN || capturedPiece != 0) {
         halfMoveClock = 0;
     } else {
         halfMoveClock++;
     }
-    
-    // Set pieceType if not already set (from movegen)
-    if (move.pieceType == 0) {
-        move.pieceType = piece_type(movingPiece);
-    }
-    
-    // Add to move history for continuation history
-    moveHistory.push_back(move);
 
     // Hash: remove side-to-move, old ep and old castling
     currentHash ^= z.side;
     if (enPassantCol != -1) currentHash ^= z.epFile[enPassantCol];
-    int oldCastling = 0;
-    if (whiteCanCastleKingSide) oldCastling |= 1;
-    if (whiteCanCastleQueenSide) oldCastling |= 2;
-    if (blackCanCastleKingSide) oldCastling |= 4;
-    if (blackCanCastleQueenSide) oldCastling |= 8;
-    currentHash ^= z.castling[oldCastling];
-
-    // Remove moving piece from origin
-    currentHash ^= z.piece[piece_to_zobrist_index(movingPiece)][fromSq];
+    currentHash ^= z.castling[castling_rights(*this)];
 
-    bb_clear(*this, movingPiece, fromSq);
-    if (target_piece != 0) {
-        bb_clear(*this, target_piece, toSq);
-        currentHash ^= z.piece[piece_to_zobrist_index(target_piece)][toSq];
+    if (capturedPiece != 0) {
+        bb_clear(*this, capturedPiece, capturedSq);
+        mailbox[capturedSq] = 0;
+        currentHash ^= z.piece[piece_to_zobrist_index(capturedPiece)][capturedSq];
+        if (piece_type(capturedPiece) == PAWN) pawnKey ^= z.piece[piece_to_zobrist_index(capturedPiece)][capturedSq];
     }
-    bb_set(*this, movingPiece, toSq);
 
+    const int placedPiece = (type == MOVE_PROMOTION) ? make_piece(move.promotion(), us) : movingPiece;
+    bb_clear(*this, movingPiece, fromSq);
+    bb_set(*this, placedPiece, toSq);
     mailbox[fromSq] = 0;
-    if (target_piece != 0) mailbox[toSq] = 0;
-
-    if (piece_type(movingPiece) == PAWN && move.fromCol != move.toCol && move.capturedPiece == 0) {
-        move.isEnPassant = true;
-        int captureRow = move.fromRow;
-        int captureSq = row_col_to_sq(captureRow, move.toCol);
-        int capturedPawn = (piece_color(movingPiece) == WHITE) ? B_PAWN : W_PAWN;
-        bb_clear(*this, capturedPawn, captureSq);
-        mailbox[captureSq] = 0;
-        currentHash ^= z.piece[piece_to_zobrist_index(capturedPawn)][captureSq];
-        move.capturedPiece = capturedPawn;
-    }
-
-    if (piece_type(movingPiece) == KING && std::abs(move.fromCol - move.toCol) == 2) {
-        if (move.toCol > move.fromCol) {
-            int rookFromSq = row_col_to_sq(move.toRow, move.toCol + 1);
-            int rookToSq = row_col_to_sq(move.toRow, move.toCol - 1);
-            int rookPiece = make_piece(ROOK, piece_color(movingPiece));
-            bb_clear(*this, rookPiece, rookFromSq);
-            bb_set(*this, rookPiece, rookToSq);
-            mailbox[rookToSq] = mailbox[rookFromSq];
-            mailbox[rookFromSq] = 0;
-            currentHash ^= z.piece[piece_to_zobrist_index(rookPiece)][rookFromSq];
-            currentHash ^= z.piece[piece_to_zobrist_index(rookPiece)][rookToSq];
-        } else {
-            int rookFromSq = row_col_to_sq(move.toRow, move.toCol - 2);
-            int rookToSq = row_col_to_sq(move.toRow, move.toCol + 1);
-            int rookPiece = make_piece(ROOK, piece_color(movingPiece));
-            bb_clear(*this, rookPiece, rookFromSq);
-            bb_set(*this, rookPiece, rookToSq);
-            mailbox[rookToSq] = mailbox[rookFromSq];
-            mailbox[rookFromSq] = 0;
-            currentHash ^= z.piece[piece_to_zobrist_index(rookPiece)][rookFromSq];
-            currentHash ^= z.piece[piece_to_zobrist_index(rookPiece)][rookToSq];
-        }
-        move.isCastling = true;
-    }
-
-    int placedPiece = movingPiece;
+    mailbox[toSq] = placedPiece;
+    currentHash ^= z.piece[piece_to_zobrist_index(movingPiece)][fromSq];
+    currentHash ^= z.piece[piece_to_zobrist_index(placedPiece)][toSq];
     if (piece_type(movingPiece) == PAWN) {
-        int promotionRank = (piece_color(movingPiece) == WHITE) ? 0 : 7;
-        if (move.toRow == promotionRank && move.promotion != 0) {
-            placedPiece = make_piece(move.promotion, piece_color(movingPiece));
-            bb_clear(*this, movingPiece, toSq);
-            bb_set(*this, placedPiece, toSq);
+        pawnKey ^= z.piece[piece_to_zobrist_index(movingPiece)][fromSq];
+        if (placedPiece == movingPiece) pawnKey ^= z.piece[piece_to_zobrist_index(placedPiece)][toSq];
+    }
+
+    if (type == MOVE_CASTLING) {
+        const bool kingSide = toSq > fromSq;
+        const int rookFromSq = kingSide ? toSq + 1 : toSq - 2;
+        const int rookToSq = kingSide ? toSq - 1 : toSq + 1;
+        const int rookPiece = make_piece(ROOK, us);
+        bb_clear(*this, rookPiece, rookFromSq);
+        bb_set(*this, rookPiece, rookToSq);
+        mailbox[rookFromSq] = 0;
+        mailbox[rookToSq] = rookPiece;
+        currentHash ^= z.piece[piece_to_zobrist_index(rookPiece)][rookFromSq];
+        currentHash ^= z.piece[piece_to_zobrist_index(rookPiece)][rookToSq];
+    }
+
+    if (!accumulators.empty()) {
+        NNUEDelta delta;
+        delta.sub(movingPiece, fromSq);
+        delta.add(placedPiece, toSq);
+        if (capturedPiece != 0) delta.sub(capturedPiece, capturedSq);
+        if (type == MOVE_CASTLING) {
+            const bool kingSide = toSq > fromSq;
+            delta.sub(make_piece(ROOK, us), kingSide ? toSq + 1 : toSq - 2);
+            delta.add(make_piece(ROOK, us), kingSide ? toSq - 1 : toSq + 1);
         }
+        nnue_push(*this, delta);
     }
 
-    mailbox[toSq] = placedPiece;
-    currentHash ^= z.piece[piece_to_zobrist_index(placedPiece)][toSq];
-
-    if (piece_type(movingPiece) == PAWN && std::abs(move.fromRow - move.toRow) == 2) {
+    enPassantCol = -1;
+    if (piece_type(movingPiece) == PAWN && std::abs(toSq - fromSq) == 16) {
         const bool opponentWhite = !isWhiteTurn;
-        const int epRow = opponentWhite ? 2 : 5;
-        const int epSq = row_col_to_sq(epRow, move.toCol);
+        const int epSq = (fromSq + toSq) / 2;
         if (is_pawn_attack_possible(*this, opponentWhite, epSq)) {
-            enPassantCol = move.toCol;
-        } else {
-            enPassantCol = -1;
+            enPassantCol = toSq & 7;
         }
-    } else {
-        enPassantCol = -1;
     }
 
     isWhiteTurn = !isWhiteTurn;
 
-    if (movingPiece == W_ROOK && move.fromRow == 7 && move.fromCol == 7){
-        whiteCanCastleKingSide = false;
-    }
-    else if (movingPiece == W_ROOK && move.fromRow == 7 && move.fromCol == 0){
-        whiteCanCastleQueenSide = false;
-    }
-    else if (movingPiece == B_ROOK && move.fromRow == 0 && move.fromCol == 7){
-        blackCanCastleKingSide = false;
-    }
-    else if (movingPiece == B_ROOK && move.fromRow == 0 && move.fromCol == 0){
-        blackCanCastleQueenSide = false;
-    }
+    // Moving from or capturing on a king or rook home square loses those rights
+    drop_castling_rights(*this, fromSq);
+    drop_castling_rights(*this, toSq);
 
-    if (movingPiece == W_KING) {
-        whiteCanCastleKingSide = false;
-        whiteCanCastleQueenSide = false;
-        whiteKingRow = move.toRow;
-        whiteKingCol = move.toCol;
-    }
-    if (movingPiece == B_KING) {
-        blackCanCastleKingSide = false;
-        blackCanCastleQueenSide = false;
-        blackKingRow = move.toRow;
-        blackKingCol = move.toCol;
-    }
-
-    if (move.capturedPiece == W_ROOK && move.toRow == 7 && move.toCol == 7) {
-        whiteCanCastleKingSide = false;
-    }
-    if (move.capturedPiece == W_ROOK && move.toRow == 7 && move.toCol == 0) {
-        whiteCanCastleQueenSide = false;
-    }
-    if (move.capturedPiece == B_ROOK && move.toRow == 0 && move.toCol == 7) {
-        blackCanCastleKingSide = false;
-    }
-    if (move.capturedPiece == B_ROOK && move.toRow == 0 && move.toCol == 0) {
-        blackCanCastleQueenSide = false;
-    }
-
-    int newCastling = 0;
-    if (whiteCanCastleKingSide) newCastling |= 1;
-    if (whiteCanCastleQueenSide) newCastling |= 2;
-    if (blackCanCastleKingSide) newCastling |= 4;
-    if (blackCanCastleQueenSide) newCastling |= 8;
-    currentHash ^= z.castling[newCastling];
+    currentHash ^= z.castling[castling_rights(*this)];
+    if (enPassantCol != -1) currentHash ^= z.epFile[enPassantCol];
 
-    if (enPassantCol != -1) {
-        currentHash ^= z.epFile[enPassantCol];
-    }
+    assert(currentHash == position_key(*this));
+    assert(pawnKey == pawn_key(*this));
+    assert(materialKey == material_key(*this));
 }
 
-void Board::unmakeMove(Move& move) {
-    const Zobrist& z = zobrist();
-    
-    // Remove from move history
-    if (!moveHistory.empty()) {
-        moveHistory.pop_back();
-    }
+void Board::unmakeMove(Move move) {
+    const UndoState& st = states.back();
 
     isWhiteTurn = !isWhiteTurn;
 
-    // Hash out side, current ep, current castling (state after move, before undo)
-    currentHash ^= z.side;
-    if (enPassantCol != -1) currentHash ^= z.epFile[enPassantCol];
-    int currCastling = 0;
-    if (whiteCanCastleKingSide) currCastling |= 1;
-    if (whiteCanCastleQueenSide) currCastling |= 2;
-    if (blackCanCastleKingSide) currCastling |= 4;
-    if (blackCanCastleQueenSide) currCastling |= 8;
-    currentHash ^= z.castling[currCastling];
-
     const int fromSq = move.from_sq();
     const int toSq = move.to_sq();
+    const int placedPiece = mailbox[toSq];
+    const int us = piece_color(placedPiece);
+    const int movingPiece = move.promotion() != 0 ? make_piece(PAWN, us) : placedPiece;
 
-    int pieceOnTo = mailbox[toSq];
-    int pieceBase = pieceOnTo;
-    if (move.promotion != 0) {
-        pieceBase = make_piece(PAWN, piece_color(pieceOnTo));
-    }
-
-    // Remove moved piece from destination
-    bb_clear(*this, pieceOnTo, toSq);
+    bb_clear(*this, placedPiece, toSq);
+    bb_set(*this, movingPiece, fromSq);
     mailbox[toSq] = 0;
-    currentHash ^= z.piece[piece_to_zobrist_index(pieceOnTo)][toSq];
-
-    // Undo castling ROOK move if needed
-    if (move.isCastling) {
-        if (move.toCol > move.fromCol) {
-            int rookFromSq = row_col_to_sq(move.toRow, move.toCol - 1);
-            int rookToSq = row_col_to_sq(move.toRow, move.toCol + 1);
-            int rookPiece = isWhiteTurn ? W_ROOK : B_ROOK;
-            bb_clear(*this, rookPiece, rookFromSq);
-            bb_set(*this, rookPiece, rookToSq);
-            mailbox[rookFromSq] = 0;
-            mailbox[rookToSq] = rookPiece;
-            currentHash ^= z.piece[piece_to_zobrist_index(rookPiece)][rookFromSq];
-            currentHash ^= z.piece[piece_to_zobrist_index(rookPiece)][rookToSq];
-        } else {
-            int rookFromSq = row_col_to_sq(move.toRow, move.toCol + 1);
-            int rookToSq = row_col_to_sq(move.toRow, move.toCol - 2);
-            int rookPiece = isWhiteTurn ? W_ROOK : B_ROOK;
-            bb_clear(*this, rookPiece, rookFromSq);
-            bb_set(*this, rookPiece, rookToSq);
-            mailbox[rookFromSq] = 0;
-            mailbox[rookToSq] = rookPiece;
-            currentHash ^= z.piece[piece_to_zobrist_index(rookPiece)][rookFromSq];
-            currentHash ^= z.piece[piece_to_zobrist_index(rookPiece)][rookToSq];
-        }
-    }
+    mailbox[fromSq] = movingPiece;
+
+    if (move.is_castling()) {
+        const bool kingSide = toSq > fromSq;
+        const int rookFromSq = kingSide ? toSq + 1 : toSq - 2;
+        const int rookToSq = kingSide ? toSq - 1 : toSq + 1;
+        const int rookPiece = make_piece(ROOK, us);
+        bb_clear(*this, rookPiece, rookToSq);
+        bb_set(*this, rookPiece, rookFromSq);
+        mailbox[rookToSq] = 0;
+        mailbox[rookFromSq] = rookPiece;
+    }
+
+    if (st.capturedPiece != 0) {
+        const int capturedSq = move.is_en_passant() ? (fromSq & 56) | (toSq & 7) : toSq;
+        bb_set(*this, st.capturedPiece, capturedSq);
+        mailbox[capturedSq] = st.capturedPiece;
+    }
+
+    set_castling_rights(*this, st.castlingRights);
+    enPassantCol = st.enPassantCol;
+    halfMoveClock = st.halfMoveClock;
+    currentHash = st.hash;
+    pawnKey = st.pawnKey;
+
+    // The accumulator stack starts at the last refresh, which search never unmakes past.
+    if (accumulators.size() > 1) accumulators.pop_back();
+
+    states.pop_back();
+    assert(currentHash == position_key(*this));
+    assert(pawnKey == pawn_key(*this));
+    assert(materialKey == material_key(*this));
+}
 
-    // Restore moving piece to origin
-    bb_set(*this, pieceBase, fromSq);
-    mailbox[fromSq] = pieceBase;
-    currentHash ^= z.piece[piece_to_zobrist_index(pieceBase)][fromSq];
+void Board::makeNullMove() {
+    const Zobrist& z = zobrist();
 
-    // Restore captured piece
-    if (move.isEnPassant) {
-        int capturedPawn = isWhiteTurn ? B_PAWN : W_PAWN;
-        int captureSq = row_col_to_sq(move.fromRow, move.toCol);
-        bb_set(*this, capturedPawn, captureSq);
-        mailbox[captureSq] = capturedPawn;
-        currentHash ^= z.piece[piece_to_zobrist_index(capturedPawn)][captureSq];
-    } else if (move.capturedPiece != 0) {
-        bb_set(*this, move.capturedPiece, toSq);
-        mailbox[toSq] = move.capturedPiece;
-        currentHash ^= z.piece[piece_to_zobrist_index(move.capturedPiece)][toSq];
-    }
+    states.push_back({Move(), EMPTY, castling_rights(*this), enPassantCol, halfMoveClock, currentHash, pawnKey});
+
+    currentHash ^= z.side;
+    if (enPassantCol != -1) currentHash ^= z.epFile[enPassantCol];
+    enPassantCol = -1; // En passant rights vanish after a null move
+    isWhiteTurn = !isWhiteTurn;
 
-    whiteCanCastleKingSide = move.prevW_KingSide;
-    whiteCanCastleQueenSide = move.prevW_QueenSide;
-    blackCanCastleKingSide = move.prevB_KingSide;
-    blackCanCastleQueenSide = move.prevB_QueenSide;
-    enPassantCol = move.prevEnPassantCol;
-    halfMoveClock = move.prevHalfMoveClock;
+    assert(currentHash == position_key(*this));
+    assert(pawnKey == pawn_key(*this));
+    assert(materialKey == material_key(*this));
+}
 
-    if (pieceBase == W_KING) {
-        whiteKingRow = move.fromRow;
-        whiteKingCol = move.fromCol;
-    }
-    if (pieceBase == B_KING) {
-        blackKingRow = move.fromRow;
-        blackKingCol = move.fromCol;
-    }
+void Board::unmakeNullMove() {
+    const UndoState& st = states.back();
 
-    int prevCastling = 0;
-    if (whiteCanCastleKingSide) prevCastling |= 1;
-    if (whiteCanCastleQueenSide) prevCastling |= 2;
-    if (blackCanCastleKingSide) prevCastling |= 4;
-    if (blackCanCastleQueenSide) prevCastling |= 8;
-    currentHash ^= z.castling[prevCastling];
+    isWhiteTurn = !isWhiteTurn;
+    enPassantCol = st.enPassantCol;
+    halfMoveClock = st.halfMoveClock;
+    currentHash = st.hash;
+    pawnKey = st.pawnKey;
 
-    if (enPassantCol != -1) currentHash ^= z.epFile[enPassantCol];
+    states.pop_back();
 }
 
 void Board::loadFromFEN(const std::string& fen) {
@@ -395,6 +348,8 @@ void Board::loadFromFEN(const std::string& fen) {
     color[WHITE] = 0ULL;
     color[BLACK] = 0ULL;
     for (int i = 0; i < 64; i++) mailbox[i] = 0;
+    for (int& count : pieces_otb) count = 0; // bb_set below indexes material keys by count
+    materialKey = 0;
 
     std::istringstream ss(fen);
     std::string position, turn, castling, enPassant;
@@ -422,16 +377,6 @@ void Board::loadFromFEN(const std::string& fen) {
             int sq = row_col_to_sq(row, col);
             bb_set(*this, pieceVal, sq);
             mailbox[sq] = pieceVal;
-
-            if (pt == KING) {
-                if (isWhite) {
-                    whiteKingRow = row;
-                    whiteKingCol = col;
-                } else {
-                    blackKingRow = row;
-                    blackKingCol = col;
-                }
-            }
             col++;
         }
     }
@@ -462,7 +407,11 @@ void Board::loadFromFEN(const std::string& fen) {
         halfMoveClock = 0;
     }
 
+    states.clear();
+    refresh_eval_state(*this);
+    nnue_refresh(*this);
     currentHash = position_key(*this);
+    pawnKey = pawn_key(*this);
 }
 
 void printBoard(const Board& board) {
@@ -495,26 +444,73 @@ void printBoard(const Board& board) {
     std::cout << "    a b c d e f g h" << std::endl;
 }
 
-Move uci_to_move(const std::string& uci) {
-    Move move;
-    move.fromCol = uci[0] - 'a';
-    move.fromRow = 8 - (uci[1] - '0');
-    move.toCol = uci[2] - 'a';
-    move.toRow = 8 - (uci[3] - '0');
-    if (uci.length() == 5) {
-        char promoChar = uci[4];
-        switch (promoChar) {
-            case 'q': move.promotion = QUEEN; break;
-            case 'r': move.promotion = ROOK; break;
-            case 'b': move.promotion = BISHOP; break;
-            case 'n': move.promotion = KNIGHT; break;
+std::string move_to_uci(const Move& move) {
+    if (move.is_none()) return "0000";
+    std::string s;
+    s += columns[move.from_sq() & 7];
+    s += static_cast<char>('1' + (move.from_sq() >> 3));
+    s += columns[move.to_sq() & 7];
+    s += static_cast<char>('1' + (move.to_sq() >> 3));
+    switch (move.promotion()) {
+        case QUEEN: s += 'q'; break;
+        case ROOK: s += 'r'; break;
+        case BISHOP: s += 'b'; break;
+        case KNIGHT: s += 'n'; break;
+    }
+    return s;
+}
+
+std::string board_to_fen(const Board& board, int fullMoveNumber) {
+    static const char pieceChars[] = " PNBRQKpnbrqk";
+    std::string fen;
+    for (int row = 0; row < 8; row++) {
+        int empty = 0;
+        for (int col = 0; col < 8; col++) {
+            int p = board.mailbox[row_col_to_sq(row, col)];
+            if (p == EMPTY) {
+                empty++;
+                continue;
+            }
+            if (empty) fen += static_cast<char>('0' + empty);
+            empty = 0;
+            fen += pieceChars[p];
         }
+        if (empty) fen += static_cast<char>('0' + empty);
+        if (row < 7) fen += '/';
+    }
+
+    fen += board.isWhiteTurn ? " w " : " b ";
+    std::string castling;
+    if (board.whiteCanCastleKingSide) castling += 'K';
+    if (board.whiteCanCastleQueenSide) castling += 'Q';
+    if (board.blackCanCastleKingSide) castling += 'k';
+    if (board.blackCanCastleQueenSide) castling += 'q';
+    fen += castling.empty() ? "-" : castling;
+
+    if (board.enPassantCol >= 0) {
+        fen += ' ';
+        fen += columns[board.enPassantCol];
+        fen += board.isWhiteTurn ? '6' : '3';
+    } else {
+        fen += " -";
+    }
+    fen += ' ' + std::to_string(board.halfMoveClock) + ' ' + std::to_string(fullMoveNumber);
+    return fen;
+}
+
+Move uci_to_move(const Board& board, const std::string& uci) {
+    // Match against the legal moves so the move type (castling, en passant) is filled in
+    MoveList moves;
+    get_capture_moves(board, moves);
+    get_quiet_moves(board, moves);
+    for (const Move& m : moves) {
+        if (move_to_uci(m) == uci) return m;
     }
-    return move;
+    return Move();
 }
 
 Zobrist::Zobrist() {
-    uint64_t seed = 0xC0FFEE1234ABCDEFULL;
+    uint64_t seed = ZOBRIST_SEED;
     for (int p = 0; p < 12; p++) {
         for (int sq = 0; sq < 64; sq++) {
             piece[p][sq] = splitmix64(seed);
@@ -523,6 +519,10 @@ Zobrist::Zobrist() {
     for (int i = 0; i < 16; i++) castling[i] = splitmix64(seed);
     for (int i = 0; i < 9; i++) epFile[i] = splitmix64(seed);
     side = splitmix64(seed);
+    // Drawn after the position keys so those (and saved hash files) are unchanged
+    for (int p = 1; p < 13; p++) {
+        for (int n = 0; n < 64; n++) material[p][n] = splitmix64(seed);
+    }
 }
 
 uint64_t Zobrist::splitmix64(uint64_t& x) {
@@ -560,20 +560,38 @@ uint64_t position_key(const Board& board) {
         }
     }
 
-    int castle = 0;
-    if (board.whiteCanCastleKingSide) castle |= 1;
-    if (board.whiteCanCastleQueenSide) castle |= 2;
-    if (board.blackCanCastleKingSide) castle |= 4;
-    if (board.blackCanCastleQueenSide) castle |= 8;
-    h ^= z.castling[castle];
+    h ^= z.castling[castling_rights(board)];
 
-    int ep = (board.enPassantCol >= 0 && board.enPassantCol < 8) ? board.enPassantCol : 8;
-    h ^= z.epFile[ep];
+    // Only a real en passant file is hashed, matching the incremental update in makeMove
+    if (board.enPassantCol >= 0 && board.enPassantCol < 8) h ^= z.epFile[board.enPassantCol];
 
     if (board.isWhiteTurn) h ^= z.side;
     return h;
 }
 
+uint64_t pawn_key(const Board& board) {
+    const Zobrist& z = zobrist();
+    uint64_t h = 0;
+    for (int c = 0; c < 2; c++) {
+        Bitboard bb = board.piece[PAWN - 1] & board.color[c];
+        while (bb) {
+            int sq = lsb(bb);
+            bb &= bb - 1;
+            h ^= z.piece[c * 6 + PAWN - 1][sq];
+        }
+    }
+    return h;
+}
+
+uint64_t material_key(const Board& board) {
+    const Zobrist& z = zobrist();
+    uint64_t h = 0;
+    for (int p = 1; p < 13; p++) {
+        for (int n = 0; n < board.pieces_otb[p]; n++) h ^= z.material[p][n];
+    }
+    return h;
+}
+
 bool is_threefold_repetition(const std::vector<uint64_t>& positionHistory) {
     if (positionHistory.empty()) return false;
     uint64_t current = positionHistory.back();
@@ -587,156 +605,279 @@ bool is_threefold_repetition(const std::vector<uint64_t>& positionHistory) {
     return false;
 }
 
-TranspositionTable globalTT;
+namespace {
 
-uint16_t TranspositionTable::packMove(const Move& m) {
-    int from = row_col_to_sq(m.fromRow, m.fromCol);
-    int to = row_col_to_sq(m.toRow, m.toCol);
+constexpr size_t LARGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// 2 MB aligned allocation so the kernel can back the table with huge pages.
+// Falls back to cache-line alignment if the large request fails.
+void* large_page_alloc(size_t bytes) {
+    const size_t size = (bytes + LARGE_PAGE_SIZE - 1) / LARGE_PAGE_SIZE * LARGE_PAGE_SIZE;
+#if defined(_WIN32)
+    void* mem = _aligned_malloc(size, LARGE_PAGE_SIZE);
+    if (!mem) mem = _aligned_malloc(bytes, 64);
+    return mem;
+#else
+    void* mem = std::aligned_alloc(LARGE_PAGE_SIZE, size);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (mem) madvise(mem, size, MADV_HUGEPAGE);
+#endif
+    if (!mem) mem = std::aligned_alloc(64, (bytes + 63) / 64 * 64);
+    return mem;
+#endif
+}
 
-    if (from < 0 || from >= 64) from = 0;
-    if (to < 0 || to >= 64) to = 0;
+void large_page_free(void* mem) {
+#if defined(_WIN32)
+    _aligned_free(mem);
+#else
+    std::free(mem);
+#endif
+}
 
-    int promo = m.promotion;
-    if (promo < 0) promo = 0;
-    if (promo > 7) promo = 7;
+// On-disk TT layout. Bump TT_FILE_VERSION whenever the entry packing changes.
+constexpr char TT_FILE_MAGIC[8] = {'S', 'O', 'L', 'O', 'T', 'T', 0, 0};
+constexpr uint32_t TT_FILE_VERSION = 3;
+constexpr size_t TT_FILE_HEADER_SIZE = 4096; // Keeps the mapped buckets page aligned
+
+struct TTFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t bucketBytes;
+    uint64_t zobristSeed;
+    uint64_t zobristCheck;  // zobrist().side, catches changes to key generation itself
+    uint64_t bucketCount;
+    uint32_t generation;
+};
+static_assert(sizeof(TTFileHeader) <= TT_FILE_HEADER_SIZE);
+
+bool header_is_compatible(const TTFileHeader& h, size_t bucketBytes) {
+    return std::memcmp(h.magic, TT_FILE_MAGIC, sizeof(TT_FILE_MAGIC)) == 0 &&
+           h.version == TT_FILE_VERSION &&
+           h.bucketBytes == bucketBytes &&
+           h.zobristSeed == ZOBRIST_SEED &&
+           h.zobristCheck == zobrist().side &&
+           h.bucketCount > 0;
+}
+
+} // namespace
 
-    return static_cast<uint16_t>((from & 63) | ((to & 63) << 6) | ((promo & 7) << 12));
+TranspositionTable globalTT;
+
+TranspositionTable::~TranspositionTable() {
+    release();
 }
 
-Move TranspositionTable::unpackMove(uint16_t packed) {
-    Move m;
-    const int from = packed & 63;
-    const int to = (packed >> 6) & 63;
-    const int promo = (packed >> 12) & 7;
+void TranspositionTable::release() {
+#if defined(__unix__) || defined(__APPLE__)
+    if (mappedBase) {
+        munmap(mappedBase, mappedSize);
+        mappedBase = nullptr;
+        mappedSize = 0;
+        table = nullptr;
+    }
+#endif
+    large_page_free(table);
+    table = nullptr;
+    bucketCount = 0;
+}
+
+bool TranspositionTable::save(const std::string& path) const {
+    if (!table || bucketCount == 0) return false;
+
+    TTFileHeader h{};
+    std::memcpy(h.magic, TT_FILE_MAGIC, sizeof(TT_FILE_MAGIC));
+    h.version = TT_FILE_VERSION;
+    h.bucketBytes = sizeof(Bucket);
+    h.zobristSeed = ZOBRIST_SEED;
+    h.zobristCheck = zobrist().side;
+    h.bucketCount = bucketCount;
+    h.generation = static_cast<uint32_t>(generation);
+
+    std::vector<char> header(TT_FILE_HEADER_SIZE, 0);
+    std::memcpy(header.data(), &h, sizeof(h));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out.write(header.data(), static_cast<std::streamsize>(header.size()));
+    out.write(reinterpret_cast<const char*>(table), static_cast<std::streamsize>(bucketCount * sizeof(Bucket)));
+    return static_cast<bool>(out);
+}
 
-    m.fromRow = sq_to_row(from);
-    m.fromCol = sq_to_col(from);
-    m.toRow = sq_to_row(to);
-    m.toCol = sq_to_col(to);
-    m.promotion = promo;
-    return m;
+bool TranspositionTable::load(const std::string& path) {
+#if defined(__unix__) || defined(__APPLE__)
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st{};
+    TTFileHeader h{};
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < TT_FILE_HEADER_SIZE ||
+        pread(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h)) ||
+        !header_is_compatible(h, sizeof(Bucket)) ||
+        static_cast<size_t>(st.st_size) != TT_FILE_HEADER_SIZE + h.bucketCount * sizeof(Bucket)) {
+        close(fd);
+        return false;
+    }
+
+    // Private mapping: pages fault in on first use and our stores never reach the file.
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return false;
+
+    release();
+    mappedBase = base;
+    mappedSize = size;
+    table = reinterpret_cast<Bucket*>(static_cast<char*>(base) + TT_FILE_HEADER_SIZE);
+#else
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    TTFileHeader h{};
+    in.read(reinterpret_cast<char*>(&h), sizeof(h));
+    in.seekg(0, std::ios::end);
+    const size_t size = static_cast<size_t>(in.tellg());
+    if (!in || !header_is_compatible(h, sizeof(Bucket)) ||
+        size != TT_FILE_HEADER_SIZE + h.bucketCount * sizeof(Bucket)) {
+        return false;
+    }
+
+    Bucket* mem = static_cast<Bucket*>(large_page_alloc(h.bucketCount * sizeof(Bucket)));
+    if (!mem) return false;
+    in.seekg(TT_FILE_HEADER_SIZE);
+    in.read(reinterpret_cast<char*>(mem), static_cast<std::streamsize>(h.bucketCount * sizeof(Bucket)));
+    if (!in) {
+        large_page_free(mem);
+        return false;
+    }
+
+    release();
+    table = mem;
+#endif
+    bucketCount = static_cast<size_t>(h.bucketCount);
+    generation = static_cast<int>(h.generation) & GENERATION_MASK;
+    return true;
 }
 
-uint64_t TranspositionTable::packData(int score, int depth, TTFlag flag, uint16_t packedMove) {
-    uint64_t data = static_cast<uint32_t>(score);
-    data |= (static_cast<uint64_t>(depth) & 0xFFULL) << 32;
-    data |= (static_cast<uint64_t>(static_cast<int>(flag)) & 0x3ULL) << 40;
-    data |= (static_cast<uint64_t>(packedMove) & 0xFFFFULL) << 42;
+uint64_t TranspositionTable::packEntry(uint64_t hash, int score, int depth, TTFlag flag, uint16_t packedMove, int gen) {
+    score = std::clamp(score, -(1 << 18) + 1, (1 << 18) - 1);
+    depth = std::clamp(depth - DEPTH_QS_NO_CHECKS, 0, 127);
+    uint64_t data = hash & 0xFFFFULL;
+    data |= static_cast<uint64_t>(packedMove) << 16;
+    data |= (static_cast<uint64_t>(score) & 0x7FFFFULL) << 32;
+    data |= static_cast<uint64_t>(depth) << 51;
+    data |= (static_cast<uint64_t>(static_cast<int>(flag)) & 0x3ULL) << 58;
+    data |= static_cast<uint64_t>(gen) << 60;
     return data;
 }
 
-void TranspositionTable::unpackData(uint64_t data, int& score, int& depth, TTFlag& flag, uint16_t& packedMove) {
-    score = static_cast<int32_t>(static_cast<uint32_t>(data & 0xFFFFFFFFULL));
-    depth = static_cast<int>((data >> 32) & 0xFFULL);
-    flag = static_cast<TTFlag>((data >> 40) & 0x3ULL);
-    packedMove = static_cast<uint16_t>((data >> 42) & 0xFFFFULL);
+void TranspositionTable::unpackEntry(uint64_t data, int& score, int& depth, TTFlag& flag, uint16_t& packedMove) {
+    packedMove = static_cast<uint16_t>(data >> 16);
+    score = static_cast<int>((data >> 32) & 0x7FFFFULL);
+    if (score & (1 << 18)) score -= (1 << 19); // Sign-extend
+    depth = entryDepth(data);
+    flag = static_cast<TTFlag>((data >> 58) & 0x3ULL);
 }
 
-void TranspositionTable::resize(int mbSize) {
-    delete[] table;
-    table = nullptr;
-    size = 0;
+void TranspositionTable::resize(int mbSize, int threads) {
+    release();
 
     if (mbSize <= 0) return;
-    const size_t bytes = static_cast<size_t>(mbSize) * 1024ULL * 1024ULL;
-    size_t count = bytes / sizeof(TTAtomicEntry);
+    const size_t bytes = static_cast<size_t>(std::min(mbSize, MAX_HASH_MB)) * 1024ULL * 1024ULL;
+    size_t count = bytes / sizeof(Bucket);
     if (count == 0) count = 1;
 
-    table = new TTAtomicEntry[count];
-    size = count;
-    clear();
-}
-
-void TranspositionTable::clear() {
-    if (!table || size == 0) return;
-    for (size_t i = 0; i < size; i++) {
-        table[i].data.store(0, std::memory_order_relaxed);
-        table[i].key.store(0, std::memory_order_relaxed);
+    table = static_cast<Bucket*>(large_page_alloc(count * sizeof(Bucket)));
+    if (!table) {
+        std::cerr << "info string failed to allocate " << mbSize << " MB for the hash table" << std::endl;
+        return;
     }
+    bucketCount = count;
+    clear(threads);
 }
 
-void TranspositionTable::store(uint64_t hash, int score, int depth, TTFlag flag, const Move& bestMove) {
-    if (!table || size == 0) return;
-
-    const size_t index = static_cast<size_t>(hash % size);
-    TTAtomicEntry& e = table[index];
-
-    const uint64_t existingKey = e.key.load(std::memory_order_relaxed);
-    const uint64_t existingData = e.data.load(std::memory_order_relaxed);
-    int existingScore = 0;
-    int existingDepth = 0;
-    TTFlag existingFlag = TTFlag::EXACT;
-    uint16_t existingMove = 0;
-    unpackData(existingData, existingScore, existingDepth, existingFlag, existingMove);
+void TranspositionTable::clear(int threads) {
+    generation = 0;
+    if (!table || bucketCount == 0) return;
+
+    // Each thread zeroes (and so first-touches) its own contiguous slice.
+    threads = std::max(1, threads);
+    const size_t slice = (bucketCount + threads - 1) / threads;
+    auto clear_slice = [this, slice](int idx) {
+        const size_t start = slice * idx;
+        if (start >= bucketCount) return;
+        const size_t len = std::min(slice, bucketCount - start);
+        std::memset(static_cast<void*>(table + start), 0, len * sizeof(Bucket));
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threads; i++) workers.emplace_back(clear_slice, i);
+    clear_slice(0);
+    for (auto& w : workers) w.join();
+}
 
-    if (existingKey == 0 || existingKey != hash || depth >= existingDepth) {
-        const uint16_t pm = packMove(bestMove);
-        const uint64_t newData = packData(score, depth, flag, pm);
-        e.data.store(newData, std::memory_order_relaxed);
-        e.key.store(hash, std::memory_order_release);
+void TranspositionTable::store(uint64_t hash, int score, int depth, TTFlag flag, const Move& bestMove, int staticEval) {
+    if (!table || bucketCount == 0) return;
+
+    Bucket& b = bucket_for(hash);
+    const uint16_t key = static_cast<uint16_t>(hash);
+
+    // Same position: refresh it unless we would overwrite a clearly deeper result of this search.
+    // Otherwise evict the entry with the lowest depth minus age (empty slots go first).
+    int victim = 0;
+    int victimWorth = VALUE_INF;
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        const uint64_t data = b.entries[i].load(std::memory_order_relaxed);
+        if (static_cast<uint16_t>(data) == key && data != 0) {
+            if (flag != EXACT && entryGeneration(data) == generation && depth + 2 < entryDepth(data)) return;
+            uint16_t move = bestMove.data;
+            if (move == 0) move = static_cast<uint16_t>(data >> 16); // Keep the old move if we have none
+            b.entries[i].store(packEntry(hash, score, depth, flag, move, generation), std::memory_order_relaxed);
+            if (staticEval != VALUE_NONE) b.evals[i].store(packEval(staticEval), std::memory_order_relaxed);
+            return;
+        }
+        const int age = (generation - entryGeneration(data)) & GENERATION_MASK;
+        const int worth = (data == 0) ? -VALUE_INF : entryDepth(data) - 8 * age;
+        if (worth < victimWorth) {
+            victimWorth = worth;
+            victim = i;
+        }
     }
-}
 
-bool TranspositionTable::probe(uint64_t key, int& outScore, int& outDepth, TTFlag& outFlag, Move& outMove) const {
-    if (!table || size == 0) return false;
+    b.entries[victim].store(packEntry(hash, score, depth, flag, bestMove.data, generation), std::memory_order_relaxed);
+    b.evals[victim].store(staticEval == VALUE_NONE ? EVAL_SLOT_NONE : packEval(staticEval), std::memory_order_relaxed);
+}
 
-    const size_t index = static_cast<size_t>(key % size);
-    const TTAtomicEntry& e = table[index];
+bool TranspositionTable::probe(uint64_t key, int& outScore, int& outDepth, TTFlag& outFlag, Move& outMove, int& outStaticEval) const {
+    if (!table || bucketCount == 0) return false;
 
-    const uint64_t foundKey = e.key.load(std::memory_order_acquire);
-    if (foundKey != key) return false;
+    const Bucket& b = bucket_for(key);
+    for (int i = 0; i < BUCKET_SIZE; i++) {
+        const uint64_t data = b.entries[i].load(std::memory_order_relaxed);
+        if (data == 0 || static_cast<uint16_t>(data) != static_cast<uint16_t>(key)) continue;
 
-    const uint64_t data = e.data.load(std::memory_order_relaxed);
-    uint16_t packedMove = 0;
-    unpackData(data, outScore, outDepth, outFlag, packedMove);
-    outMove = unpackMove(packedMove);
-    return true;
+        uint16_t packedMove = 0;
+        unpackEntry(data, outScore, outDepth, outFlag, packedMove);
+        outMove = Move(packedMove);
+        const int16_t eval = b.evals[i].load(std::memory_order_relaxed);
+        outStaticEval = (eval == EVAL_SLOT_NONE) ? VALUE_NONE : eval;
+        return true;
+    }
+    return false;
 }
 
 // SEE piece values; keep close to MVV/LVA ordering, not evaluation values
 const int see_piece_values[] = {0, 100, 320, 330, 500, 900, 20000};
 
-static Bitboard attackers_to_sq(Bitboard pieces[2][6], int sq, int side, Bitboard occ) {
-    Bitboard attackers = 0ULL;
-
-    // Pawns: to find pawns of 'side' that attack 'sq', use pawn_attacks of the opposite side.
-    attackers |= ((side == WHITE) ? pawn_attacks[BLACK][sq] : pawn_attacks[WHITE][sq]) & pieces[side][PAWN - 1];
-    attackers |= knight_attacks[sq] & pieces[side][KNIGHT - 1];
-    attackers |= king_attacks[sq] & pieces[side][KING - 1];
-    attackers |= bishop_attacks_on_the_fly(sq, occ) & (pieces[side][BISHOP - 1] | pieces[side][QUEEN - 1]);
-    attackers |= rook_attacks_on_the_fly(sq, occ) & (pieces[side][ROOK - 1] | pieces[side][QUEEN - 1]);
-    return attackers;
-}
-
-inline int moveEstimatedValue(const Move& move){
+inline int moveEstimatedValue(const Board& board, const Move& move){
     int value = 0;
-    if (is_quiet(move)) return 0;
-    if (move.promotion != 0) {
-        value += see_piece_values[move.promotion] - see_piece_values[PAWN]; // A pawn goes, a promoted piece comes
+    if (move.promotion() != 0) {
+        value += see_piece_values[move.promotion()] - see_piece_values[PAWN]; // A pawn goes, a promoted piece comes
     }
-    value += see_piece_values[piece_type(move.capturedPiece)];
+    value += see_piece_values[piece_type(captured_piece(board, move))];
     return value;
 }
 
-// All attackers to a square (both sides)
-static Bitboard all_attackers_to_sq(const Board& board, int sq, Bitboard occ) {
-    Bitboard attackers = 0ULL;
-    
-    // Pawns
-    attackers |= pawn_attacks[BLACK][sq] & board.piece[PAWN - 1] & board.color[WHITE];
-    attackers |= pawn_attacks[WHITE][sq] & board.piece[PAWN - 1] & board.color[BLACK];
-    // Knights
-    attackers |= knight_attacks[sq] & board.piece[KNIGHT - 1];
-    // Kings
-    attackers |= king_attacks[sq] & board.piece[KING - 1];
-    // Bishops and Queens (diagonal)
-    attackers |= bishop_attacks_on_the_fly(sq, occ) & (board.piece[BISHOP - 1] | board.piece[QUEEN - 1]);
-    // Rooks and Queens (orthogonal)
-    attackers |= rook_attacks_on_the_fly(sq, occ) & (board.piece[ROOK - 1] | board.piece[QUEEN - 1]);
-    
-    return attackers;
-}
-
 int staticExchangeEvaluation(const Board& board, const Move& move, int threshold) {
     // Ethereal-style threshold-based SEE
     int from = move.from_sq();
@@ -747,12 +888,12 @@ int staticExchangeEvaluation(const Board& board, const Move& move, int threshold
 
     // Determine the piece that will be on 'to' after the move (for recapture value)
     // If promotion, it's the promoted piece; otherwise, it's the moving piece
-    nextVictim = (move.promotion != 0) 
-               ? move.promotion 
+    nextVictim = (move.promotion() != 0)
+               ? move.promotion()
                : piece_type(board.mailbox[from]);
 
     // Balance is the value of the move minus threshold
-    balance = moveEstimatedValue(move) - threshold;
+    balance = moveEstimatedValue(board, move) - threshold;
 
     // Best case still fails to beat the threshold
     if (balance < 0) return 0;
@@ -773,15 +914,13 @@ int staticExchangeEvaluation(const Board& board, const Move& move, int threshold
     occupied = (occupied ^ (1ULL << from)) | (1ULL << to);
 
     // Handle en passant: remove the captured pawn
-    if (move.isEnPassant) {
-        int capRow = move.fromRow;
-        int capCol = move.toCol;
-        int capSq = row_col_to_sq(capRow, capCol);
+    if (move.is_en_passant()) {
+        int capSq = (from & 56) | (to & 7);
         occupied ^= (1ULL << capSq);
     }
 
     // Get all pieces which attack the target square
-    attackers = all_attackers_to_sq(board, to, occupied) & occupied;
+    attackers = attackers_to(board, to, occupied) & occupied;
 
     // Now opponent's turn to recapture
     int colour = board.isWhiteTurn ? BLACK : WHITE;
@@ -809,11 +948,11 @@ int staticExchangeEvaluation(const Board& board, const Move& move, int threshold
 
         // A diagonal move may reveal bishop or queen attackers
         if (nextVictim == PAWN || nextVictim == BISHOP || nextVictim == QUEEN)
-            attackers |= bishop_attacks_on_the_fly(to, occupied) & bishops;
+            attackers |= get_bishop_attacks(to, occupied) & bishops;
 
         // A vertical or horizontal move may reveal rook or queen attackers
         if (nextVictim == ROOK || nextVictim == QUEEN)
-            attackers |= rook_attacks_on_the_fly(to, occupied) & rooks;
+            attackers |= get_rook_attacks(to, occupied) & rooks;
 
         // Make sure we did not add any already used attacks
         attackers &= occupied;
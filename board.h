@@ -1,11 +1,13 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <string>
 #include <vector>
 
+#include "nnue.h"
 #include "types.h"
 
 extern char columns[];
@@ -49,6 +51,8 @@ inline constexpr int MAX_PLY = 128;
 inline constexpr int MATE_SCORE = 100000;
 inline constexpr int VALUE_INF = 2000000000;   // Infinite score for alpha-beta bounds
 inline constexpr int VALUE_NONE = -200000;     // Initial value before any move is searched
+inline constexpr int DEPTH_QS_CHECKS = 0;      // TT depth of quiescence nodes in check or trying quiet checks
+inline constexpr int DEPTH_QS_NO_CHECKS = -1;  // TT depth of captures-only quiescence nodes
 
 // Move ordering scores
 inline constexpr int SCORE_TT_MOVE      = 1000000;
@@ -79,75 +83,110 @@ inline constexpr int other_color(int c) { return c ^ 1; }
 
 extern int pieces_on_board[14]; // Simplified piece count for endgame detection (2 knights, 2 bishops, 2 rooks, 1 queen per side)
 
-struct Move {
-    int fromRow, fromCol;
-    int toRow, toCol;
-    int capturedPiece;
-    int promotion;
-    int pieceType;  // Moving piece type (1-6: pawn-king)
+// Move kind, stored in the top two bits of a Move.
+enum MoveType : uint16_t {
+    MOVE_NORMAL     = 0,
+    MOVE_PROMOTION  = 1 << 14,
+    MOVE_EN_PASSANT = 2 << 14,
+    MOVE_CASTLING   = 3 << 14
+};
 
-    bool prevW_KingSide;
-    bool prevW_QueenSide;
-    bool prevB_KingSide;
-    bool prevB_QueenSide;
+// 16-bit move: bits 0-5 from square, 6-11 to square, 12-13 promotion piece
+// (KNIGHT..QUEEN minus KNIGHT), 14-15 MoveType. Undo information lives in
+// Board's state stack, so a move is just an identifier. Move() (a1a1) is "no move".
+struct Move {
+    uint16_t data;
+
+    constexpr Move() : data(0) {}
+    constexpr explicit Move(uint16_t raw) : data(raw) {}
+    constexpr Move(int from, int to, MoveType type = MOVE_NORMAL, int promotion = KNIGHT)
+        : data(static_cast<uint16_t>(from | (to << 6) | ((promotion - KNIGHT) << 12) | type)) {}
+
+    constexpr int from_sq() const { return data & 63; }
+    constexpr int to_sq() const { return (data >> 6) & 63; }
+    constexpr MoveType type() const { return static_cast<MoveType>(data & (3 << 14)); }
+    // Promoted piece type, or 0 if this is not a promotion
+    constexpr int promotion() const { return type() == MOVE_PROMOTION ? ((data >> 12) & 3) + KNIGHT : 0; }
+    constexpr bool is_en_passant() const { return type() == MOVE_EN_PASSANT; }
+    constexpr bool is_castling() const { return type() == MOVE_CASTLING; }
+    constexpr bool is_none() const { return data == 0; }
+
+    constexpr bool operator==(const Move& other) const { return data == other.data; }
+};
 
-    int prevEnPassantCol;
-    int prevHalfMoveClock;  // For 50-move rule undo
+// Compare two moves for equality
+inline bool moves_equal(const Move& a, const Move& b) {
+    return a.data == b.data;
+}
 
-    bool isEnPassant;
-    bool isCastling;
+inline constexpr int MAX_MOVES = 256; // No legal chess position has more than 218 moves
 
-    Move();
+// Fixed-capacity move list with inline storage, so generating moves never touches the heap.
+struct MoveList {
+    union { Move moves[MAX_MOVES]; }; // Left uninitialized; only [0, count) is valid
+    int count;
 
-    // Helper methods for square-based access
-    int from_sq() const { return (7 - fromRow) * 8 + fromCol; }
-    int to_sq() const { return (7 - toRow) * 8 + toCol; }
-};
+    MoveList() : count(0) {}
 
-// Compare two moves for equality (from/to squares and promotion)
-inline bool moves_equal(const Move& a, const Move& b) {
-    return a.fromRow == b.fromRow && a.fromCol == b.fromCol &&
-           a.toRow == b.toRow && a.toCol == b.toCol &&
-           a.promotion == b.promotion;
-}
+    void push_back(const Move& m) { moves[count++] = m; }
+    void clear() { count = 0; }
+    int size() const { return count; }
+    bool empty() const { return count == 0; }
 
-// Move type helpers
-inline bool is_quiet(const Move& m) {
-    return m.capturedPiece == 0 && !m.isEnPassant && m.promotion == 0;
-}
+    Move& operator[](int i) { return moves[i]; }
+    const Move& operator[](int i) const { return moves[i]; }
+    Move* begin() { return moves; }
+    Move* end() { return moves + count; }
+    const Move* begin() const { return moves; }
+    const Move* end() const { return moves + count; }
+};
 
-inline bool is_capture(const Move& m) {
-    return m.capturedPiece != 0 || m.isEnPassant;
-}
+// State that makeMove overwrites, pushed once per ply so unmakeMove can restore it.
+struct UndoState {
+    Move move;
+    int capturedPiece;      // Piece removed by the move (the pawn for en passant), or EMPTY
+    int castlingRights;     // 1 = K, 2 = Q, 4 = k, 8 = q
+    int enPassantCol;
+    int halfMoveClock;
+    uint64_t hash;
+    uint64_t pawnKey;
+};
 
 class Board {
 public:
-    int pieces_otb[14];
+    int pieces_otb[14]; // Piece counts by piece code (1-12)
     bool isWhiteTurn;
 
+    // Incremental evaluation state, maintained by makeMove/unmakeMove and loadFromFEN
+    int psqtScore;      // Packed mg/eg material + PSQT sum, white minus black (see evaluation.h)
+
     Bitboard piece[6];
     Bitboard color[2];
 
     int mailbox[64]; // Redundant mailbox for O(1) piece lookups
     uint64_t currentHash; // Incremental Zobrist hash of the current position
-    
-    std::vector<Move> moveHistory; // History of moves for continuation history
+    uint64_t pawnKey;     // Zobrist hash of the pawns only (pawn structure cache key)
+    uint64_t materialKey; // Hash of the piece counts (material table key), kept with pieces_otb
+
+    std::vector<UndoState> states; // One entry per move made; back() describes the last move
+    std::vector<NNUEAccumulator> accumulators; // NNUE accumulator per ply; empty when NNUE is off
 
     bool whiteCanCastleKingSide;
     bool whiteCanCastleQueenSide;
     bool blackCanCastleKingSide;
     bool blackCanCastleQueenSide;
 
-    int whiteKingRow, whiteKingCol;
-    int blackKingRow, blackKingCol;
     int enPassantCol;
     int halfMoveClock;  // Moves since last pawn move or capture (50-move rule)
 
     Board();
     void loadFromFEN(const std::string& fen);
     void resetBoard();
-    void makeMove(Move& move);
-    void unmakeMove(Move& move);
+    void makeMove(Move move);
+    void unmakeMove(Move move);
+    // Pass the turn (null-move pruning); shares the state stack with makeMove.
+    void makeNullMove();
+    void unmakeNullMove();
 };
 
 inline int row_col_to_sq(int row, int col) {
@@ -170,6 +209,21 @@ inline int piece_at_sq(const Board& board, int sq) {
 inline int side_to_move(const Board& b) { return b.isWhiteTurn ? WHITE : BLACK; }
 inline int opponent(const Board& b) { return b.isWhiteTurn ? BLACK : WHITE; }
 
+// Piece a move captures (the enemy pawn for en passant), or EMPTY.
+inline int captured_piece(const Board& board, const Move& move) {
+    if (move.is_en_passant()) return board.isWhiteTurn ? B_PAWN : W_PAWN;
+    return board.mailbox[move.to_sq()];
+}
+
+// Move type helpers (the move must not have been made yet)
+inline bool is_capture(const Board& board, const Move& move) {
+    return captured_piece(board, move) != EMPTY;
+}
+
+inline bool is_quiet(const Board& board, const Move& move) {
+    return !is_capture(board, move) && move.promotion() == 0;
+}
+
 inline bool king_square(const Board& board, bool white, int& outRow, int& outCol) {
     Bitboard k = board.piece[KING - 1] & board.color[white ? WHITE : BLACK];
     if (!k) return false;
@@ -179,24 +233,42 @@ inline bool king_square(const Board& board, bool white, int& outRow, int& outCol
     return true;
 }
 
-// Move generation functions
-std::vector<Move> get_all_moves(Board& board, bool isWhiteTurn = true);
-std::vector<Move> get_capture_moves(const Board& board);
+// Move generation functions, filling a MoveList in place (no allocation).
+// All generators are fully legal: checkers and pins are computed once per call,
+// so only king moves and en passant need an attack test.
+struct AttackInfo;
+void get_all_moves(Board& board, MoveList& moves);          // Legal moves
+void get_capture_moves(const Board& board, MoveList& moves); // Appends legal captures (incl. en passant)
+void get_quiet_moves(const Board& board, MoveList& moves);   // Appends legal non-captures (incl. castling)
+// Same, reusing the node's attack info (see attacks.h) instead of recomputing it.
+void get_capture_moves(const Board& board, const AttackInfo& info, MoveList& moves);
+void get_quiet_moves(const Board& board, const AttackInfo& info, MoveList& moves);
+
+// Could `move` (e.g. a TT or killer move from another position) be generated here,
+// ignoring checks and pins?
+bool is_pseudo_legal(const Board& board, const Move& move);
+// Does `move` (pseudo-legal) leave our own king safe? Uses pins/checkers, no make/unmake.
+bool is_legal(const Board& board, const Move& move);
+bool is_legal(const Board& board, const Move& move, const AttackInfo& info);
 
 // Attack detection
 bool is_square_attacked(const Board& board, int row, int col, bool isWhiteAttacker);
-int see_exchange(const Board& board, const Move& move);
 int staticExchangeEvaluation(const Board& board, const Move& move, int threshold);
 // Utility functions
 void printBoard(const Board& board);
-Move uci_to_move(const std::string& uci);
+Move uci_to_move(const Board& board, const std::string& uci); // Move() if not legal here
+std::string move_to_uci(const Move& move);
+std::string board_to_fen(const Board& board, int fullMoveNumber = 1);
 
 // Zobrist hashing
+inline constexpr uint64_t ZOBRIST_SEED = 0xC0FFEE1234ABCDEFULL;
+
 struct Zobrist {
     uint64_t piece[12][64]{};
     uint64_t castling[16]{};
     uint64_t epFile[9]{};
     uint64_t side{};
+    uint64_t material[13][64]{}; // [piece code][count before adding]: material signature keys
 
     static uint64_t splitmix64(uint64_t& x);
     Zobrist();
@@ -204,7 +276,9 @@ struct Zobrist {
 
 const Zobrist& zobrist();
 int piece_to_zobrist_index(int piece);
-uint64_t position_key(const Board& board);
+uint64_t position_key(const Board& board); // Full rebuild; search uses Board::currentHash
+uint64_t pawn_key(const Board& board);     // Full rebuild; search uses Board::pawnKey
+uint64_t material_key(const Board& board); // Full rebuild from pieces_otb; search uses Board::materialKey
 bool is_threefold_repetition(const std::vector<uint64_t>& positionHistory);
 
 // Draw detection
@@ -224,39 +298,91 @@ enum TTFlag {
     BETA        // Lower bound (fail-high)
 };
 
+inline constexpr int MAX_HASH_MB = 65536;
+
 class TranspositionTable {
 public:
-    TranspositionTable() : table(nullptr), size(0) {}
-    ~TranspositionTable() { delete[] table; }
-
-    // Resize the table to given size in MB (count = bytes / sizeof(entry)).
-    void resize(int mbSize);
-    void clear();
-
-    // Lockless + thread-safe: write data first, then publish key with release semantics.
-    void store(uint64_t hash, int score, int depth, TTFlag flag, const Move& bestMove);
+    TranspositionTable() : table(nullptr), bucketCount(0), generation(0), mappedBase(nullptr), mappedSize(0) {}
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    // Resize the table to given size in MB (bucketCount = bytes / sizeof(Bucket)).
+    // Memory is 2 MB aligned and, on Linux, advised to use transparent huge pages.
+    void resize(int mbSize, int threads = 1);
+    // Zero the table, splitting the work over `threads` threads.
+    void clear(int threads = 1);
+
+    // Persist the table: a 4096-byte header (format version, Zobrist seed, size) followed by the
+    // raw buckets. load() maps the file copy-on-write where possible, so it is usable immediately;
+    // the file itself is never modified. Both return false (leaving the table untouched) on error.
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+    // Age existing entries; call once per search so stale ones are replaced first.
+    void new_search() { generation = (generation + 1) & GENERATION_MASK; }
+
+    // Lockless + thread-safe: every entry is one atomic 64-bit word, so readers never see a torn write.
+    // staticEval is the node's static evaluation (VALUE_NONE if unknown; the stored one is kept).
+    // It sits in a separate 16-bit slot, so a racing writer can at worst pair an entry with a
+    // stale eval, which only affects pruning decisions.
+    void store(uint64_t hash, int score, int depth, TTFlag flag, const Move& bestMove, int staticEval = VALUE_NONE);
 
     // Backward-compatible overload (older call sites passing an int)
     void store(uint64_t hash, int score, int depth, int flag, const Move& bestMove) {
         store(hash, score, depth, static_cast<TTFlag>(flag), bestMove);
     }
 
-    bool probe(uint64_t key, int& outScore, int& outDepth, TTFlag& outFlag, Move& outMove) const;
-    size_t entryCount() const { return size; }
+    bool probe(uint64_t key, int& outScore, int& outDepth, TTFlag& outFlag, Move& outMove) const {
+        int staticEval;
+        return probe(key, outScore, outDepth, outFlag, outMove, staticEval);
+    }
+    bool probe(uint64_t key, int& outScore, int& outDepth, TTFlag& outFlag, Move& outMove, int& outStaticEval) const;
+
+    // Start loading the bucket for `key` so a later probe of it does not stall on memory.
+    void prefetch(uint64_t key) const {
+#if defined(__GNUC__) || defined(__clang__)
+        if (table) __builtin_prefetch(&bucket_for(key));
+#else
+        (void)key;
+#endif
+    }
+
+    size_t entryCount() const { return bucketCount * BUCKET_SIZE; }
 
 private:
-    struct TTAtomicEntry {
-        std::atomic<uint64_t> key{0};
-        std::atomic<uint64_t> data{0};
+    // Entry layout (low to high bits): key 16, move 16, score 19, depth 7, flag 2, generation 4.
+    // Depths are stored relative to DEPTH_QS_NO_CHECKS, the shallowest depth the search stores.
+    // The key is the low 16 bits of the hash; the bucket index comes from the high bits.
+    // Each entry's static eval lives in evals[] (EVAL_SLOT_NONE when unknown).
+    static constexpr int BUCKET_SIZE = 3;
+    static constexpr int GENERATION_MASK = 15;
+    static constexpr int16_t EVAL_SLOT_NONE = INT16_MIN;
+
+    struct alignas(32) Bucket {
+        std::atomic<uint64_t> entries[BUCKET_SIZE];
+        std::atomic<int16_t> evals[BUCKET_SIZE];
+        int16_t padding;
     };
+    static_assert(sizeof(Bucket) == 32, "TT bucket must stay half a cache line");
+
+    Bucket* table;
+    size_t bucketCount;
+    int generation;
+    void* mappedBase;   // Non-null when `table` lives inside a file mapping from load()
+    size_t mappedSize;
 
-    TTAtomicEntry* table;
-    size_t size;
+    void release();
+
+    Bucket& bucket_for(uint64_t hash) const {
+        return table[static_cast<size_t>((static_cast<unsigned __int128>(hash) * bucketCount) >> 64)];
+    }
 
-    static uint16_t packMove(const Move& m);
-    static Move unpackMove(uint16_t packed);
-    static uint64_t packData(int score, int depth, TTFlag flag, uint16_t packedMove);
-    static void unpackData(uint64_t data, int& score, int& depth, TTFlag& flag, uint16_t& packedMove);
+    static uint64_t packEntry(uint64_t hash, int score, int depth, TTFlag flag, uint16_t packedMove, int gen);
+    static void unpackEntry(uint64_t data, int& score, int& depth, TTFlag& flag, uint16_t& packedMove);
+    static int entryDepth(uint64_t data) { return static_cast<int>((data >> 51) & 0x7F) + DEPTH_QS_NO_CHECKS; }
+    static int entryGeneration(uint64_t data) { return static_cast<int>(data >> 60); }
+    static int16_t packEval(int eval) { return static_cast<int16_t>(std::clamp(eval, -32767, 32767)); }
 };
 
 extern TranspositionTable globalTT;
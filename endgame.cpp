@@ -0,0 +1,215 @@
+#include "endgame.h"
+#include "bitboard.h"
+#include "evaluation.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+inline int rank_of(int sq) { return sq >> 3; }
+inline int file_of(int sq) { return sq & 7; }
+
+inline int distance(int a, int b) {
+    return std::max(std::abs(rank_of(a) - rank_of(b)), std::abs(file_of(a) - file_of(b)));
+}
+
+// Larger the closer `sq` is to an edge (0 in the centre, 120 in a corner).
+inline int push_to_edge(int sq) {
+    const int r = rank_of(sq), f = file_of(sq);
+    return 20 * ((3 - std::min(r, 7 - r)) + (3 - std::min(f, 7 - f)));
+}
+
+// Larger the closer the kings are.
+inline int push_close(int a, int b) {
+    return 20 * (8 - distance(a, b));
+}
+
+int king_sq(const Board& board, int c) {
+    return lsb(board.piece[KING - 1] & board.color[c]);
+}
+
+// Lone king to move with no legal move and not in check.
+bool lone_king_stalemated(const Board& board, int weakSide) {
+    if (side_to_move(board) != weakSide) return false;
+    const int ksq = king_sq(board, weakSide);
+    const bool byWhite = weakSide == BLACK;
+    if (is_square_attacked(board, sq_to_row(ksq), sq_to_col(ksq), byWhite)) return false;
+    Bitboard moves = king_attacks[ksq] & ~board.color[weakSide];
+    while (moves) {
+        const int to = lsb(moves);
+        moves &= moves - 1;
+        if (!is_square_attacked(board, sq_to_row(to), sq_to_col(to), byWhite)) return false;
+    }
+    return true;
+}
+
+int non_pawn_material(const Board& board, int c) {
+    return PIECE_VALUES[KNIGHT] * board.pieces_otb[make_piece(KNIGHT, c)] +
+           PIECE_VALUES[BISHOP] * board.pieces_otb[make_piece(BISHOP, c)] +
+           PIECE_VALUES[ROOK] * board.pieces_otb[make_piece(ROOK, c)] +
+           PIECE_VALUES[QUEEN] * board.pieces_otb[make_piece(QUEEN, c)];
+}
+
+// ---- KPK bitbase ----
+// Index: side to move (1 bit), black king (6), white king (6), pawn file a-d (2), pawn rank 2-7 (3).
+
+constexpr int KPK_SIZE = 1 << 18;
+uint32_t kpkBits[KPK_SIZE / 32];
+
+enum : uint8_t { KPK_INVALID = 0, KPK_UNKNOWN = 1, KPK_DRAW = 2, KPK_WIN = 4 };
+
+inline int kpk_index(int stm, int bksq, int wksq, int psq) {
+    return stm | (bksq << 1) | (wksq << 7) | (file_of(psq) << 13) | ((rank_of(psq) - 1) << 15);
+}
+
+uint8_t kpk_initial(int stm, int bksq, int wksq, int psq) {
+    const Bitboard pawnAttacks = pawn_attacks[WHITE][psq];
+    if (distance(wksq, bksq) <= 1 || wksq == psq || bksq == psq) return KPK_INVALID;
+    if (stm == WHITE && (pawnAttacks & (1ULL << bksq))) return KPK_INVALID;
+
+    if (stm == WHITE) {
+        // Promotes and the new queen cannot be taken
+        const int promoSq = psq + 8;
+        if (rank_of(psq) == 6 && wksq != promoSq && bksq != promoSq &&
+            (distance(bksq, promoSq) > 1 || distance(wksq, promoSq) == 1)) {
+            return KPK_WIN;
+        }
+        return KPK_UNKNOWN;
+    }
+
+    const Bitboard safe = king_attacks[bksq] & ~(king_attacks[wksq] | pawnAttacks);
+    if (safe & (1ULL << psq)) return KPK_DRAW;           // Takes the undefended pawn
+    if (!safe) return (pawnAttacks & (1ULL << bksq)) ? KPK_WIN : KPK_DRAW; // Mate or stalemate
+    return KPK_UNKNOWN;
+}
+
+uint8_t kpk_classify(const std::vector<uint8_t>& db, int stm, int bksq, int wksq, int psq) {
+    uint8_t r = KPK_INVALID;
+    if (stm == WHITE) {
+        Bitboard moves = king_attacks[wksq] & ~king_attacks[bksq] & ~(1ULL << psq);
+        while (moves) {
+            const int to = lsb(moves);
+            moves &= moves - 1;
+            r |= db[kpk_index(BLACK, bksq, to, psq)];
+        }
+        // Pushes to the 8th rank are either an initial win or lose the queen
+        const int push = psq + 8;
+        if (rank_of(psq) < 6 && push != wksq && push != bksq) {
+            r |= db[kpk_index(BLACK, bksq, wksq, push)];
+            if (rank_of(psq) == 1 && push + 8 != wksq && push + 8 != bksq) {
+                r |= db[kpk_index(BLACK, bksq, wksq, push + 8)];
+            }
+        }
+        return (r & KPK_WIN) ? KPK_WIN : (r & KPK_UNKNOWN) ? KPK_UNKNOWN : KPK_DRAW;
+    }
+
+    Bitboard moves = king_attacks[bksq] & ~(king_attacks[wksq] | pawn_attacks[WHITE][psq]);
+    while (moves) {
+        const int to = lsb(moves);
+        moves &= moves - 1;
+        r |= db[kpk_index(WHITE, to, wksq, psq)];
+    }
+    return (r & KPK_DRAW) ? KPK_DRAW : (r & KPK_UNKNOWN) ? KPK_UNKNOWN : KPK_WIN;
+}
+
+} // namespace
+
+void kpk_init() {
+    std::vector<uint8_t> db(KPK_SIZE, KPK_INVALID);
+
+    auto for_each_position = [](auto&& fn) {
+        for (int psq = 8; psq < 56; psq++) {
+            if (file_of(psq) > 3) continue;
+            for (int wksq = 0; wksq < 64; wksq++)
+                for (int bksq = 0; bksq < 64; bksq++)
+                    for (int stm = WHITE; stm <= BLACK; stm++) fn(stm, bksq, wksq, psq);
+        }
+    };
+
+    for_each_position([&](int stm, int bksq, int wksq, int psq) {
+        db[kpk_index(stm, bksq, wksq, psq)] = kpk_initial(stm, bksq, wksq, psq);
+    });
+
+    // Resolve unknown positions from their successors until nothing changes;
+    // whatever stays unknown can never be forced, so it is a draw.
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for_each_position([&](int stm, int bksq, int wksq, int psq) {
+            uint8_t& v = db[kpk_index(stm, bksq, wksq, psq)];
+            if (v != KPK_UNKNOWN) return;
+            v = kpk_classify(db, stm, bksq, wksq, psq);
+            if (v != KPK_UNKNOWN) changed = true;
+        });
+    }
+
+    for (int i = 0; i < KPK_SIZE; i++) {
+        if (db[i] == KPK_WIN) kpkBits[i / 32] |= 1u << (i & 31);
+    }
+}
+
+bool kpk_probe(int wksq, int psq, int bksq, int stm) {
+    const int idx = kpk_index(stm, bksq, wksq, psq);
+    return kpkBits[idx / 32] & (1u << (idx & 31));
+}
+
+int eval_kxk(const Board& board, int strongSide) {
+    const int weakSide = strongSide ^ 1;
+    if (lone_king_stalemated(board, weakSide)) return 0;
+
+    const int strongK = king_sq(board, strongSide);
+    const int weakK = king_sq(board, weakSide);
+    int score = non_pawn_material(board, strongSide) +
+                PIECE_VALUES[PAWN] * board.pieces_otb[make_piece(PAWN, strongSide)] +
+                push_to_edge(weakK) + push_close(strongK, weakK);
+
+    const Bitboard bishops = board.piece[BISHOP - 1] & board.color[strongSide];
+    constexpr Bitboard DARK_SQUARES = 0xAA55AA55AA55AA55ULL;
+    if (board.pieces_otb[make_piece(QUEEN, strongSide)] || board.pieces_otb[make_piece(ROOK, strongSide)] ||
+        (bishops && board.pieces_otb[make_piece(KNIGHT, strongSide)]) ||
+        ((bishops & DARK_SQUARES) && (bishops & ~DARK_SQUARES))) {
+        score += KNOWN_WIN;
+    }
+    return score;
+}
+
+int eval_kbnk(const Board& board, int strongSide) {
+    const int weakSide = strongSide ^ 1;
+    if (lone_king_stalemated(board, weakSide)) return 0;
+
+    const int strongK = king_sq(board, strongSide);
+    const int weakK = king_sq(board, weakSide);
+    const int bishopSq = lsb(board.piece[BISHOP - 1] & board.color[strongSide]);
+
+    // Mate is only possible in a corner of the bishop's colour (a1 is dark)
+    const bool darkBishop = ((rank_of(bishopSq) + file_of(bishopSq)) & 1) == 0;
+    const int cornerA = darkBishop ? 0 : 7;   // a1 or h1
+    const int cornerB = darkBishop ? 63 : 56; // h8 or a8
+    auto manhattan = [](int a, int b) { return std::abs(rank_of(a) - rank_of(b)) + std::abs(file_of(a) - file_of(b)); };
+    const int cornerDist = std::min(manhattan(weakK, cornerA), manhattan(weakK, cornerB));
+
+    return KNOWN_WIN + PIECE_VALUES[KNIGHT] + PIECE_VALUES[BISHOP] +
+           20 * (14 - cornerDist) + push_close(strongK, weakK);
+}
+
+int eval_kpk(const Board& board, int strongSide) {
+    // Normalise: strong side is white, pawn on files a-d
+    int wksq = king_sq(board, strongSide);
+    int bksq = king_sq(board, strongSide ^ 1);
+    int psq = lsb(board.piece[PAWN - 1] & board.color[strongSide]);
+    int stm = side_to_move(board) == strongSide ? WHITE : BLACK;
+    if (strongSide == BLACK) {
+        wksq ^= 56;
+        bksq ^= 56;
+        psq ^= 56;
+    }
+    if (file_of(psq) > 3) {
+        wksq ^= 7;
+        bksq ^= 7;
+        psq ^= 7;
+    }
+
+    if (!kpk_probe(wksq, psq, bksq, stm)) return 0;
+    return KNOWN_WIN + PIECE_VALUES[PAWN] + 10 * rank_of(psq);
+}
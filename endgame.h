@@ -0,0 +1,22 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include "board.h"
+
+// Score for a known won endgame: above any ordinary evaluation, well below mate scores.
+inline constexpr int KNOWN_WIN = 10000;
+
+// Specialised evaluator for one material configuration; the score is from
+// `strongSide`'s point of view. Selected through the material table.
+using EndgameFn = int (*)(const Board& board, int strongSide);
+
+int eval_kxk(const Board& board, int strongSide);   // Mating material (and maybe pawns) vs lone king
+int eval_kbnk(const Board& board, int strongSide);  // Bishop and knight vs lone king
+int eval_kpk(const Board& board, int strongSide);   // King and pawn vs king (bitbase)
+
+// KPK bitbase, built by retrograde analysis; call once at startup.
+void kpk_init();
+// Is it a win for white? Pawn on files a-d, ranks 2-7; stm is WHITE or BLACK.
+bool kpk_probe(int wksq, int psq, int bksq, int stm);
+
+#endif
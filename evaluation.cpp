@@ -1,7 +1,9 @@
 #include "evaluation.h"
+#include <algorithm>
 #include <cmath>
 #include "board.h"
 #include "bitboard.h"
+#include "attacks.h"
 #include <iostream>
 
 // Bit manipulation - using inline functions from types.h
@@ -181,127 +183,177 @@ const int eg_king_table[64] = {
 const int* mg_pesto_tables[6] = { mg_pawn_table, mg_knight_table, mg_bishop_table, mg_rook_table, mg_queen_table, mg_king_table };
 const int* eg_pesto_tables[6] = { eg_pawn_table, eg_knight_table, eg_bishop_table, eg_rook_table, eg_queen_table, eg_king_table };
 
-namespace {
-int mg_table[12][64];
-int eg_table[12][64];
-bool tables_initialized = false;
-
-int piece_to_table_index(int piece) {
-    const int absPiece = piece > 0 ? piece : -piece;
-    if (absPiece < 1 || absPiece > 6) return -1;
-    return absPiece - 1;
-}
+int psqt_table[13][64];
 
-void init_tables() {
+void init_eval_tables() {
+    kpk_init();
     for (int p = 0; p < 6; ++p) {
-        const int wIdx = p * 2;
-        const int bIdx = p * 2 + 1;
         for (int sq = 0; sq < 64; ++sq) {
             const int msq = mirror_sq(sq);
             // PSTs are A8..H1; board squares are A1..H8.
             // White uses mirrored squares, black uses raw squares.
-            mg_table[wIdx][sq] = mg_value[p] + mg_pesto_tables[p][msq];
-            eg_table[wIdx][sq] = eg_value[p] + eg_pesto_tables[p][msq];
-            mg_table[bIdx][sq] = mg_value[p] + mg_pesto_tables[p][sq];
-            eg_table[bIdx][sq] = eg_value[p] + eg_pesto_tables[p][sq];
+            psqt_table[make_piece(p + 1, WHITE)][sq] =
+                make_score(mg_value[p] + mg_pesto_tables[p][msq], eg_value[p] + eg_pesto_tables[p][msq]);
+            psqt_table[make_piece(p + 1, BLACK)][sq] =
+                -make_score(mg_value[p] + mg_pesto_tables[p][sq], eg_value[p] + eg_pesto_tables[p][sq]);
         }
     }
 }
 
-void ensure_tables_init() {
-    if (!tables_initialized) {
-        init_tables();
-        tables_initialized = true;
-    }
-}
+// Mobility of colour `c`: squares each piece attacks that are not occupied by its own side.
+int evaluate_mobility(const Board& board, const AttackMaps& maps, int c) {
+    const Bitboard notOwn = ~board.color[c];
+    int totalMobility = 0;
+    for (int k = 0; k < maps.count[c][KNIGHT]; k++) totalMobility += KnightMobility[popcount(maps.pieces[c][KNIGHT][k] & notOwn)];
+    for (int k = 0; k < maps.count[c][BISHOP]; k++) totalMobility += BishopMobility[popcount(maps.pieces[c][BISHOP][k] & notOwn)];
+    for (int k = 0; k < maps.count[c][ROOK]; k++) totalMobility += RookMobility[popcount(maps.pieces[c][ROOK][k] & notOwn)];
+    for (int k = 0; k < maps.count[c][QUEEN]; k++) totalMobility += QueenMobility[popcount(maps.pieces[c][QUEEN][k] & notOwn)];
+    return totalMobility;
 }
 
-int evaluate_mobility(const Board& board, int pieceType, bool isWhite, Bitboard occupy) {
-    Bitboard myPieces = isWhite ? board.color[WHITE] : board.color[BLACK];
-    
-    Bitboard pieces = board.piece[pieceType - 1] & myPieces;
-    int totalMobility = 0;
+// Terms that combine the cached pawn structure with the king positions, white POV.
+int evaluate_pawn_king(const Board& board, const PawnEntry& pawns) {
+    int score = 0;
+    for (int c = WHITE; c <= BLACK; c++) {
+        const int sign = c == WHITE ? 1 : -1;
+        const Bitboard ourPawns = board.piece[PAWN - 1] & board.color[c];
+        const Bitboard ourKing = board.piece[KING - 1] & board.color[c];
+        const Bitboard theirKing = board.piece[KING - 1] & board.color[OTHER(c)];
+        if (!ourKing || !theirKing) continue;
+        const int ksq = lsb(ourKing);
+        const int theirKsq = lsb(theirKing);
+
+        // Pawn shield in front of a castled-style king (middlegame only)
+        const int kRelRank = c == WHITE ? ksq >> 3 : 7 - (ksq >> 3);
+        if (kRelRank <= 1) {
+            const int kf = ksq & 7;
+            Bitboard files = 0;
+            for (int f = std::max(0, kf - 1); f <= std::min(7, kf + 1); f++) files |= 0x0101010101010101ULL << f;
+            const int step = c == WHITE ? 8 : -8;
+            const Bitboard rank1 = 0xFFULL << (ksq + step - (ksq & 7));
+            const Bitboard rank2 = c == WHITE ? rank1 << 8 : rank1 >> 8;
+            const int shield = 12 * popcount(ourPawns & files & rank1) + 6 * popcount(ourPawns & files & rank2);
+            score += sign * make_score(shield, 0);
+        }
 
-    while (pieces) {
-        int sq = lsb(pieces);
-        pop_bit(pieces, sq);
-        
-        Bitboard attacks = 0ULL;
-
-        switch (pieceType) {
-            case KNIGHT:
-                attacks = knight_attacks[sq];
-                break;
-            case BISHOP:
-                attacks = get_bishop_attacks(sq, occupy);
-                break;
-            case ROOK:
-                attacks = get_rook_attacks(sq, occupy);
-                break;
-            case QUEEN:
-                attacks = get_bishop_attacks(sq, occupy) | get_rook_attacks(sq, occupy);
-                break;
+        // Passed pawns are worth more in the endgame when our king escorts them
+        Bitboard passed = pawns.passed[c];
+        while (passed) {
+            const int sq = lsb(passed);
+            passed &= passed - 1;
+            const int relRank = c == WHITE ? sq >> 3 : 7 - (sq >> 3);
+            if (relRank < 3) continue;
+            const int stop = sq + (c == WHITE ? 8 : -8);
+            auto dist = [](int a, int b) { return std::max(std::abs((a >> 3) - (b >> 3)), std::abs((a & 7) - (b & 7))); };
+            const int weight = relRank - 2;
+            score += sign * make_score(0, weight * (5 * dist(theirKsq, stop) - 2 * dist(ksq, stop)));
         }
+    }
+    return score;
+}
 
-        Bitboard validMoves = attacks & ~myPieces;
-        
-        int mobilityCount = popcount(validMoves);
+// Score of a known endgame for the side to move.
+int evaluate_endgame(const Board& board, const MaterialEntry& material) {
+    const int score = material.evalFn(board, material.strongSide);
+    return side_to_move(board) == material.strongSide ? score : -score;
+}
 
-        if (pieceType == KNIGHT) totalMobility += KnightMobility[mobilityCount];
-        else if (pieceType == BISHOP) totalMobility += BishopMobility[mobilityCount];
-        else if (pieceType == ROOK) totalMobility += RookMobility[mobilityCount];
-        else if (pieceType == QUEEN) totalMobility += QueenMobility[mobilityCount];
+// Endgame scale for the side the endgame score favours.
+int endgame_scale(const Board& board, const MaterialEntry& material, int egWhite) {
+    const int strong = egWhite > 0 ? WHITE : BLACK;
+    int scale = material.scale[strong];
+    if (material.bishopsOnly) {
+        constexpr Bitboard DARK_SQUARES = 0xAA55AA55AA55AA55ULL;
+        const Bitboard bishops = board.piece[BISHOP - 1];
+        if ((bishops & DARK_SQUARES) && (bishops & ~DARK_SQUARES)) scale = std::min(scale, SCALE_NORMAL / 2);
     }
-    
-    return totalMobility;
+    return scale;
 }
 
-int evaluate_board(const Board& board) {
-    ensure_tables_init();
-
-    int mg[2] = {0, 0};
-    int eg[2] = {0, 0};
-    int gamePhase = 0;
-    int side2move = board.isWhiteTurn ? WHITE : BLACK;
-
-    for (int color = 0; color < 2; color++) {
-        for (int p = 0; p < 6; p++) {
-            Bitboard bb = board.piece[p] & board.color[color];
-            const int tableIdx = p * 2 + (color == BLACK ? 1 : 0);
-            while (bb) {
-                int sq = lsb(bb);
-                bb &= bb - 1;
-            mg[color] += mg_table[tableIdx][sq];
-            eg[color] += eg_table[tableIdx][sq];
-            gamePhase += gamephaseInc[p];
-            }
-        }
-    }
+// Classic evaluation. With `lazy`, returns the score before mobility when that is already
+// more than LAZY_EVAL_MARGIN outside [alpha, beta] (exact is then set to false).
+int evaluate_classic(const Board& board, EvalTables& tables, bool lazy, int alpha, int beta, bool& exact,
+                     const AttackMaps* maps = nullptr) {
+    exact = true;
+    const MaterialEntry& material = probe_material(board, tables.material);
+    if (material.evalFn) return evaluate_endgame(board, material);
+
+    // Material and piece-square terms are kept up to date by Board::makeMove;
+    // pawn structure and material imbalance come from their hash tables.
+    const PawnEntry& pawns = probe_pawns(board, tables.pawns);
+    const int whiteScore = board.psqtScore + material.imbalance + pawns.score + evaluate_pawn_king(board, pawns);
 
     /* tapered eval */
-    int mgScore = mg[side2move] - mg[OTHER(side2move)];
-    int egScore = eg[side2move] - eg[OTHER(side2move)];
-    
-    int mgPhase = gamePhase;
-    if (mgPhase > 24) mgPhase = 24; 
-    
+    int mgScore = score_mg(whiteScore);
+    int egScore = score_eg(whiteScore) * endgame_scale(board, material, score_eg(whiteScore)) / SCALE_NORMAL;
+    if (!board.isWhiteTurn) {
+        mgScore = -mgScore;
+        egScore = -egScore;
+    }
+
+    int mgPhase = material.gamePhase;
     int egPhase = 24 - mgPhase;
     
     int staticEval = (mgScore * mgPhase + egScore * egPhase) / 24;
 
+    if (lazy) {
+        tables.stats.lazyCalls++;
+        // Return the bound on the full score that faces the window: it is still outside it,
+        // and below alpha stays an upper bound for delta pruning
+        if (staticEval - LAZY_EVAL_MARGIN >= beta) {
+            tables.stats.lazyExits++;
+            exact = false;
+            return staticEval - LAZY_EVAL_MARGIN;
+        }
+        if (staticEval + LAZY_EVAL_MARGIN <= alpha) {
+            tables.stats.lazyExits++;
+            exact = false;
+            return staticEval + LAZY_EVAL_MARGIN;
+        }
+    }
+
     // Mobility evaluation
-    int mobilityScore = 0;
-    Bitboard occupy = board.color[WHITE] | board.color[BLACK];
-    for (int pieceType = KNIGHT; pieceType <= QUEEN; pieceType++) {
-        mobilityScore += evaluate_mobility(board, pieceType, board.isWhiteTurn, occupy);
-        mobilityScore -= evaluate_mobility(board, pieceType, !board.isWhiteTurn, occupy);
+    AttackMaps localMaps;
+    if (!maps) {
+        compute_attack_maps(board, localMaps);
+        maps = &localMaps;
     }
+    const int us = side_to_move(board);
+    const int mobilityScore = evaluate_mobility(board, *maps, us) - evaluate_mobility(board, *maps, OTHER(us));
 
     return (staticEval + mobilityScore);
 }
 
-int evaluate_board_pesto(const Board& board) {
-    return evaluate_board(board);
+bool classic_eval_terms(const Board& board, EvalTables& tables, ClassicEvalTerms& terms) {
+    const MaterialEntry& material = probe_material(board, tables.material);
+    if (material.evalFn) return false;
+    const PawnEntry& pawns = probe_pawns(board, tables.pawns);
+    terms.fixed = material.imbalance + pawns.score + evaluate_pawn_king(board, pawns);
+    terms.phase = material.gamePhase;
+    terms.scale[WHITE] = endgame_scale(board, material, 1);
+    terms.scale[BLACK] = endgame_scale(board, material, -1);
+    return true;
+}
+
+int evaluate_board_pesto(const Board& board, EvalTables& tables, const AttackMaps* maps) {
+    bool exact;
+    return evaluate_classic(board, tables, false, 0, 0, exact, maps);
+}
+
+int evaluate_board(const Board& board, EvalTables& tables, const AttackMaps* maps) {
+    if (board.accumulators.empty()) return evaluate_board_pesto(board, tables, maps);
+    const MaterialEntry& material = probe_material(board, tables.material);
+    if (material.evalFn) return evaluate_endgame(board, material);
+    return nnue_evaluate(board);
+}
+
+int evaluate_board(const Board& board, EvalTables& tables, int alpha, int beta, bool& exact) {
+    // NNUE has no separable expensive term, so it is always evaluated in full
+    if (!board.accumulators.empty()) {
+        exact = true;
+        return evaluate_board(board, tables);
+    }
+    return evaluate_classic(board, tables, true, alpha, beta, exact);
 }
 
 int repetition_draw_score(const Board& board) {
@@ -2,16 +2,101 @@
 #define EVALUATION_H
 
 #include "board.h"
+#include "material.h"
+#include "pawns.h"
+#include <algorithm>
+#include <vector>
 
 // Piece values
 extern const int PIECE_VALUES[7];
 
+// Middlegame/endgame pair packed into one int (eg in the high half), so both
+// phases are updated with a single add. Each half must stay within int16.
+constexpr int make_score(int mg, int eg) {
+    return static_cast<int>(static_cast<unsigned>(eg) << 16) + mg;
+}
+inline int score_mg(int s) { return static_cast<int16_t>(static_cast<uint16_t>(static_cast<unsigned>(s))); }
+inline int score_eg(int s) { return static_cast<int16_t>(static_cast<uint16_t>(static_cast<unsigned>(s + 0x8000) >> 16)); }
+
+// Packed PeSTO material + square values by piece code (1-12), from white's point
+// of view (black entries are negated). Board keeps the running sum in psqtScore.
+extern int psqt_table[13][64];
+extern const int gamephaseInc[6];
+
+// Builds psqt_table; call once at startup before any Board is set up.
+void init_eval_tables();
+
+// Classic evaluation weights (PeSTO tables are A8..H1, white's view), exposed for the tuner.
+extern const int mg_value[6];
+extern const int eg_value[6];
+extern const int* mg_pesto_tables[6];
+extern const int* eg_pesto_tables[6];
+extern const int KnightMobility[9];
+extern const int BishopMobility[14];
+extern const int RookMobility[15];
+extern const int QueenMobility[28];
+
+
 extern int center_distance(int row, int col);
 extern int manhattan_distance(int r1, int c1, int r2, int c2);
 
 // Evaluation functions
-int evaluate_board_pesto(const Board& board);
-int evaluate_board(const Board& board);
+// Lazy-evaluation call counters (windowed evaluate_board only).
+struct EvalStats {
+    uint64_t lazyCalls = 0;  // Classic evals that reached the lazy-exit test
+    uint64_t lazyExits = 0;  // ... and returned before mobility
+};
+
+// Per-thread caches behind the evaluation (owned by SearchThread).
+struct EvalTables {
+    PawnTable pawns;
+    MaterialTable material;
+    EvalStats stats;
+};
+
+// Bound on the mobility term the lazy evaluation skips. The largest mobility difference
+// measured over bench was 89 cp (none above 100), so 120 leaves headroom.
+inline constexpr int LAZY_EVAL_MARGIN = 120;
+
+struct AttackMaps;
+
+// Known endgames (KPK, KBNK, KXK) use their specialised evaluator with either network.
+// `maps` may pass the position's attack maps when the caller already has them.
+int evaluate_board_pesto(const Board& board, EvalTables& tables, const AttackMaps* maps = nullptr); // Classic PeSTO + pawns + mobility
+int evaluate_board(const Board& board, EvalTables& tables, const AttackMaps* maps = nullptr);       // NNUE when a network is loaded, else classic
+// Windowed variant: when the cheap material + PSQT + pawn part is beyond [alpha, beta] by
+// LAZY_EVAL_MARGIN, returns it without mobility and sets exact = false (the score is then only
+// good for that window and must not be cached).
+int evaluate_board(const Board& board, EvalTables& tables, int alpha, int beta, bool& exact);
 int repetition_draw_score(const Board& board);
 
+// The classic evaluation terms the tuner (tuner.cpp) keeps fixed, white POV.
+struct ClassicEvalTerms {
+    int fixed;      // Packed mg/eg: imbalance, pawn structure and pawn-king terms (no PSQT, no mobility)
+    int phase;      // Middlegame weight, 0..24
+    int scale[2];   // Endgame scale (of SCALE_NORMAL) when that colour leads on the eg score
+};
+// False when a specialised endgame evaluator replaces the classic evaluation.
+bool classic_eval_terms(const Board& board, EvalTables& tables, ClassicEvalTerms& terms);
+
+// Per-thread cache of static evaluations keyed by Board::currentHash. Each slot packs the
+// upper 48 bits of the hash with the 16-bit eval. Clear it whenever the evaluator changes.
+struct EvalCache {
+    static constexpr size_t SIZE = 1 << 16; // Power of two
+
+    std::vector<uint64_t> entries = std::vector<uint64_t>(SIZE, 0);
+
+    bool probe(uint64_t hash, int& eval) const {
+        const uint64_t e = entries[hash & (SIZE - 1)];
+        if (e == 0 || (e ^ hash) >> 16) return false;
+        eval = static_cast<int16_t>(e & 0xFFFF);
+        return true;
+    }
+    void store(uint64_t hash, int eval) {
+        eval = std::clamp(eval, -32767, 32767);
+        entries[hash & (SIZE - 1)] = (hash & ~0xFFFFULL) | static_cast<uint16_t>(eval);
+    }
+    void clear() { std::fill(entries.begin(), entries.end(), 0); }
+};
+
 #endif
\ No newline at end of file
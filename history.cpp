@@ -2,67 +2,65 @@
 #include <cstring>
 #include <algorithm>
 
-int historyTable[64][64];
-Move killerMove[2][MAX_PLY];
 constexpr int HISTORY_MAX = 16384;
 
-void clear_history() {
-    std::memset(historyTable, 0, sizeof(historyTable));
+void clear_history(SearchHistory& history) {
+    std::memset(history.historyTable, 0, sizeof(history.historyTable));
 }
 
-void update_history(int fromSq, int toSq, int depth, const Move badQuiets[256], const int& badQuietCount) { 
+void update_history(SearchHistory& history, int fromSq, int toSq, int depth, const Move badQuiets[256], const int& badQuietCount) { 
 
     int bonus = std::min(10 + 200 * depth, 4096);
-    int& bestScore = historyTable[fromSq][toSq];
+    int& bestScore = history.historyTable[fromSq][toSq];
 
     bestScore += bonus - (bestScore * std::abs(bonus)) / HISTORY_MAX;
 
     for (int i = 0; i < badQuietCount; ++i) {
-        int badFrom = row_col_to_sq(badQuiets[i].fromRow, badQuiets[i].fromCol);
-        int badTo = row_col_to_sq(badQuiets[i].toRow, badQuiets[i].toCol);
+        int badFrom = badQuiets[i].from_sq();
+        int badTo = badQuiets[i].to_sq();
 
         if (badFrom == fromSq && badTo == toSq) {
             continue;
         }
 
         int malus = bonus + (i * 30);
-        int& badScore = historyTable[badFrom][badTo];
+        int& badScore = history.historyTable[badFrom][badTo];
         
         badScore -= malus + (badScore * std::abs(malus)) / HISTORY_MAX;
     }
 }
 
-int get_history_score(int fromSq, int toSq) {
-    return historyTable[fromSq][toSq];
+int get_history_score(const SearchHistory& history, int fromSq, int toSq) {
+    return history.historyTable[fromSq][toSq];
 }
 
-void add_killer_move(const Move& move, int ply) {
+void add_killer_move(SearchHistory& history, const Move& move, int ply) {
     if (ply < 0 || ply >= MAX_PLY) return;
     
-    if (moves_equal(move, killerMove[0][ply])) {
+    if (moves_equal(move, history.killerMove[0][ply])) {
         return;
     }
 
     // Promote killer1 to killer0 when it triggers again.
-    if (moves_equal(move, killerMove[1][ply])) {
-        killerMove[1][ply] = killerMove[0][ply];
-        killerMove[0][ply] = move;
+    if (moves_equal(move, history.killerMove[1][ply])) {
+        history.killerMove[1][ply] = history.killerMove[0][ply];
+        history.killerMove[0][ply] = move;
         return;
     }
 
-    killerMove[1][ply] = killerMove[0][ply];
-    killerMove[0][ply] = move;
+    history.killerMove[1][ply] = history.killerMove[0][ply];
+    history.killerMove[0][ply] = move;
 }
 
-Move get_killer_move(int index, int ply) {
+Move get_killer_move(const SearchHistory& history, int index, int ply) {
     if (ply < 0 || ply >= MAX_PLY) return Move();
-    return killerMove[index][ply];
+    return history.killerMove[index][ply];
 }
 
-void clear_killer_moves() {
+void clear_killer_moves(SearchHistory& history) {
     for (int i = 0; i < 2; ++i) {
         for (int j = 0; j < MAX_PLY; ++j) {
-            killerMove[i][j] = Move(); // Reset to default Move
+            history.killerMove[i][j] = Move(); // Reset to default Move
         }
     }
 }
@@ -3,24 +3,28 @@
 
 #include "board.h"
 
-// History table: [fromSquare][toSquare]
-// Each square is from 0-63, total 64x64 = 4096 entries
-extern int historyTable[64][64];
-extern Move killerMove[2][MAX_PLY]; // 2 slots
+// Move ordering heuristics owned by a single search thread.
+// Lazy SMP helpers each keep their own copy so they never write into each other's tables.
+struct SearchHistory {
+    // History table: [fromSquare][toSquare]
+    // Each square is from 0-63, total 64x64 = 4096 entries
+    int historyTable[64][64];
+    Move killerMove[2][MAX_PLY]; // 2 slots
+};
 
 // History functions
-void clear_history();                          // Reset history table
-void update_history(int fromSq, int toSq, int depth, const Move badQuiets[256], const int& badQuietCount); // Update on beta cutoff
-int get_history_score(int fromSq, int toSq);  // Get score for move ordering
-void add_killer_move(const Move& move, int ply); // Update killer moves
-Move get_killer_move(int index, int ply); // Get killer moves
-void clear_killer_moves(); // Clear killer moves
+void clear_history(SearchHistory& history);                          // Reset history table
+void update_history(SearchHistory& history, int fromSq, int toSq, int depth, const Move badQuiets[256], const int& badQuietCount); // Update on beta cutoff
+int get_history_score(const SearchHistory& history, int fromSq, int toSq);  // Get score for move ordering
+void add_killer_move(SearchHistory& history, const Move& move, int ply); // Update killer moves
+Move get_killer_move(const SearchHistory& history, int index, int ply); // Get killer moves
+void clear_killer_moves(SearchHistory& history); // Clear killer moves
 
 // Helper to check if a move is a killer move at given ply
-inline bool is_killer_move(const Move& move, int ply) {
+inline bool is_killer_move(const SearchHistory& history, const Move& move, int ply) {
     if (ply < 0 || ply >= MAX_PLY) return false;
-    return moves_equal(move, get_killer_move(0, ply)) || 
-           moves_equal(move, get_killer_move(1, ply));
+    return moves_equal(move, get_killer_move(history, 0, ply)) || 
+           moves_equal(move, get_killer_move(history, 1, ply));
 }
 
-#endif
\ No newline at end of file
+#endif
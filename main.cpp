@@ -2,6 +2,7 @@
 #include "bitboard.h"
 #include "search.h"
 #include "evaluation.h"
+#include "attacks.h"
 #include <iostream>
 #include <string>
 #include <sstream>
@@ -10,29 +11,23 @@
 #include <algorithm>
 #include <thread>
 #include <atomic>
+#include <cstdlib>
 
 #define VERSION "1.3.1"
 
 static uint64_t perft(Board& board, int depth) {
     if (depth <= 0) return 1ULL;
 
-    uint64_t nodes = 0;
-    std::vector<Move> moves = get_all_moves(board, board.isWhiteTurn);
-    for (Move& move : moves) {
-        board.makeMove(move);
-
-        int kingRow = 0;
-        int kingCol = 0;
-        if (!king_square(board, !board.isWhiteTurn, kingRow, kingCol)) {
-            board.unmakeMove(move);
-            continue;
-        }
-        const bool illegal = is_square_attacked(board, kingRow, kingCol, board.isWhiteTurn);
+    MoveList moves;
+    get_all_moves(board, moves);
 
-        if (!illegal) {
-            nodes += perft(board, depth - 1);
-        }
+    // The generator is fully legal, so the last ply is just a count.
+    if (depth == 1) return static_cast<uint64_t>(moves.size());
 
+    uint64_t nodes = 0;
+    for (const Move& move : moves) {
+        board.makeMove(move);
+        nodes += perft(board, depth - 1);
         board.unmakeMove(move);
     }
 
@@ -67,37 +62,19 @@ void bench() {
         "r1bq1rk1/pp2ppbp/2np1np1/8/3NP3/2N1B3/PPP1BPPP/R2Q1RK1 w - - 0 9",
     };
 
-    auto move_to_uci = [](const Move& m) {
-        if (m.fromRow == 0 && m.fromCol == 0 && m.toRow == 0 && m.toCol == 0 && m.promotion == 0) return std::string("0000");
-        std::string s;
-        s += columns[m.fromCol];
-        s += static_cast<char>('0' + (8 - m.fromRow));
-        s += columns[m.toCol];
-        s += static_cast<char>('0' + (8 - m.toRow));
-        if (m.promotion != 0) {
-            switch (m.promotion) {
-                case QUEEN: s += 'q'; break;
-                case ROOK: s += 'r'; break;
-                case BISHOP: s += 'b'; break;
-                case KNIGHT: s += 'n'; break;
-                default: break;
-            }
-        }
-        return s;
-    };
-
     uint64_t totalNodes = 0;
     long long totalTimeMs = 0;
 
     Board board;
     if (globalTT.entryCount() == 0) globalTT.resize(16);
-    globalTT.clear();
+    globalTT.clear(get_thread_count());
+    reset_eval_stats();
 
     for (size_t i = 0; i < fens.size(); ++i) {
         board.loadFromFEN(fens[i]);
         std::vector<uint64_t> positionHistory;
         positionHistory.reserve(64);
-        positionHistory.push_back(position_key(board));
+        positionHistory.push_back(board.currentHash);
 
         resetNodeCounter();
         auto startTime = std::chrono::steady_clock::now();
@@ -125,14 +102,22 @@ void bench() {
     std::cout << "bench total nodes " << totalNodes
               << " time " << safeMs << "ms nps " << totalNps
               << std::endl;
+    uint64_t lazyCalls = 0, lazyExits = 0;
+    get_eval_stats(lazyCalls, lazyExits);
+    std::cout << "info string lazy eval exits " << lazyExits << " of " << lazyCalls << " ("
+              << (lazyCalls ? lazyExits * 100 / lazyCalls : 0) << "%)" << std::endl;
+    std::cout << "info string slider attack kernel " << slider_kernel_name() << std::endl;
     std::cout << "Bench: " << totalNodes << std::endl;
 }
 
 int main(int argc, char* argv[]) {
     std::cout.setf(std::ios::unitbuf); // Disable output buffering
     init_all();
+    init_eval_tables();
     initLMRtables();
     if (argc > 1 && std::string(argv[1]) == "bench") {
+        // Optional second argument: number of search threads (e.g. "bench 8")
+        if (argc > 2) set_thread_count(std::atoi(argv[2]));
         bench();
         return 0;
     }
@@ -183,8 +168,9 @@ int main(int argc, char* argv[]) {
         if (line == "uci") {
             std::cout << "id name SoloEngine " << VERSION << std::endl;
             std::cout << "id author xsolod3v" << std::endl;
-            std::cout << "option name Hash type spin default 128 min 1 max 2048" << std::endl;
-            std::cout << "option name Threads type spin default 1 min 1 max 8" << std::endl;
+            std::cout << "option name Hash type spin default 128 min 1 max " << MAX_HASH_MB << std::endl;
+            std::cout << "option name Threads type spin default 1 min 1 max " << MAX_THREADS << std::endl;
+            std::cout << "option name EvalFile type string default <empty>" << std::endl;
             std::cout << "option name UseTT type check default true" << std::endl;
             std::cout << "uciok" << std::endl;
         }
@@ -218,9 +204,26 @@ int main(int argc, char* argv[]) {
                 }
             }
             if (name == "Hash") {
-                int mb = std::max(1, std::stoi(value));
-                globalTT.resize(mb);
-                globalTT.clear();
+                stop_and_join_search();
+                int mb = std::clamp(std::stoi(value), 1, MAX_HASH_MB);
+                globalTT.resize(mb, get_thread_count());
+            } else if (name == "Threads") {
+                stop_and_join_search();
+                set_thread_count(std::stoi(value));
+            } else if (name == "EvalFile") {
+                stop_and_join_search();
+                if (value.empty() || value == "<empty>") {
+                    nnue_disable();
+                    std::cout << "info string NNUE disabled, using classic evaluation" << std::endl;
+                } else if (nnue_load(value)) {
+                    std::cout << "info string NNUE network loaded from " << value << std::endl;
+                } else {
+                    std::cout << "info string failed to load NNUE network " << value << ", keeping current evaluation" << std::endl;
+                }
+                nnue_refresh(board);
+                // Cached static evals came from the previous evaluator
+                globalTT.clear(get_thread_count());
+                clear_eval_caches();
             } else if (name == "UseTT") {
                 std::string v = value;
                 std::transform(v.begin(), v.end(), v.begin(), ::tolower);
@@ -242,12 +245,22 @@ int main(int argc, char* argv[]) {
             }
         }
 
+        // savehash <file> / loadhash <file>: keep the transposition table across sessions
+        else if (line.rfind("savehash ", 0) == 0 || line.rfind("loadhash ", 0) == 0) {
+            stop_and_join_search();
+            const bool saving = line[0] == 's';
+            const std::string path = line.substr(9);
+            const bool ok = saving ? globalTT.save(path) : globalTT.load(path);
+            std::cout << "info string " << (saving ? "save" : "load") << " hash " << path
+                      << (ok ? " ok" : " failed") << std::endl;
+        }
+
         else if (line == "ucinewgame") {
             stop_and_join_search();
-            globalTT.clear();
+            globalTT.clear(get_thread_count());
             board.resetBoard();
             gameHistory.clear();
-            gameHistory.push_back(position_key(board));
+            gameHistory.push_back(board.currentHash);
             clear_search_heuristics();
         }
 
@@ -268,7 +281,7 @@ int main(int argc, char* argv[]) {
                 board.loadFromFEN(fenStr);
             }
             gameHistory.clear();
-            gameHistory.push_back(position_key(board));
+            gameHistory.push_back(board.currentHash);
             
             size_t movesPos = line.find("moves");
             if (movesPos != std::string::npos) {
@@ -278,9 +291,10 @@ int main(int argc, char* argv[]) {
                 std::string moveToken;
                 
                 while (ss >> moveToken) {
-                    Move m = uci_to_move(moveToken);
+                    Move m = uci_to_move(board, moveToken);
+                    if (m.is_none()) break; // Illegal or malformed move: ignore the rest
                     board.makeMove(m);
-                    gameHistory.push_back(position_key(board));
+                    gameHistory.push_back(board.currentHash);
                 }
             }
         }
@@ -346,24 +360,8 @@ int main(int argc, char* argv[]) {
             searchThread = std::thread([&board, &gameHistory, searchDepth, timeToThink, &searchRunning]() {
                 Move best = getBestMove(board, searchDepth, timeToThink, gameHistory);
 
-                // If no legal move was found (mate/stalemate), output UCI null move.
-                if (best.fromRow == 0 && best.fromCol == 0 && best.toRow == 0 && best.toCol == 0 && best.promotion == 0) {
-                    std::cout << "bestmove 0000" << std::endl;
-                } else {
-                    std::cout << "bestmove "
-                              << columns[best.fromCol] << (8 - best.fromRow)
-                              << columns[best.toCol] << (8 - best.toRow);
-                    if (best.promotion != 0) {
-                        switch (abs(best.promotion)) {
-                            case QUEEN: std::cout << 'q'; break;
-                            case ROOK: std::cout << 'r'; break;
-                            case BISHOP: std::cout << 'b'; break;
-                            case KNIGHT: std::cout << 'n'; break;
-                            default: break;
-                        }
-                    }
-                    std::cout << std::endl;
-                }
+                // If no legal move was found (mate/stalemate), move_to_uci prints the UCI null move.
+                std::cout << "bestmove " << move_to_uci(best) << std::endl;
                 searchRunning.store(false, std::memory_order_relaxed);
             });
         }
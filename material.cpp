@@ -0,0 +1,102 @@
+#include "material.h"
+#include "evaluation.h"
+#include <algorithm>
+
+namespace {
+
+constexpr int BishopPair = make_score(30, 50);
+constexpr int KnightPawnAdjust = make_score(3, 4);  // Per own pawn above five, per knight
+constexpr int RookPawnAdjust = make_score(-3, -4);  // Per own pawn above five, per rook
+
+constexpr int SCALE_ONE_PAWN = 48;
+
+int count(const Board& board, int type, int c) {
+    return board.pieces_otb[make_piece(type, c)];
+}
+
+int non_pawn_material(const Board& board, int c) {
+    return PIECE_VALUES[KNIGHT] * count(board, KNIGHT, c) + PIECE_VALUES[BISHOP] * count(board, BISHOP, c) +
+           PIECE_VALUES[ROOK] * count(board, ROOK, c) + PIECE_VALUES[QUEEN] * count(board, QUEEN, c);
+}
+
+int imbalance(const Board& board, int c) {
+    const int pawnsAboveFive = count(board, PAWN, c) - 5;
+    int score = 0;
+    if (count(board, BISHOP, c) >= 2) score += BishopPair;
+    score += KnightPawnAdjust * pawnsAboveFive * count(board, KNIGHT, c);
+    score += RookPawnAdjust * pawnsAboveFive * count(board, ROOK, c);
+    return score;
+}
+
+// Specialised evaluator when `weak` has a bare king, else nullptr.
+EndgameFn find_endgame(const Board& board, int strong) {
+    const int weak = strong ^ 1;
+    if (count(board, PAWN, weak) || non_pawn_material(board, weak)) return nullptr;
+
+    const int npm = non_pawn_material(board, strong);
+    const int pawns = count(board, PAWN, strong);
+    if (!pawns && npm == PIECE_VALUES[KNIGHT] + PIECE_VALUES[BISHOP] &&
+        count(board, KNIGHT, strong) == 1) {
+        return eval_kbnk;
+    }
+    if (pawns == 1 && npm == 0) return eval_kpk;
+    if (npm >= PIECE_VALUES[ROOK]) return eval_kxk;
+    return nullptr;
+}
+
+void compute_entry(const Board& board, MaterialEntry& e) {
+    e.evalFn = nullptr;
+    e.strongSide = WHITE;
+    for (int c = WHITE; c <= BLACK; c++) {
+        if (EndgameFn fn = find_endgame(board, c)) {
+            e.evalFn = fn;
+            e.strongSide = static_cast<uint8_t>(c);
+        }
+    }
+
+    int phase = 0;
+    for (int type = PAWN; type <= KING; type++) {
+        phase += gamephaseInc[type - 1] * (count(board, type, WHITE) + count(board, type, BLACK));
+    }
+    e.gamePhase = static_cast<uint8_t>(std::min(phase, 24));
+    e.imbalance = imbalance(board, WHITE) - imbalance(board, BLACK);
+
+    // Without pawns a small material edge rarely wins
+    for (int c = WHITE; c <= BLACK; c++) {
+        const int npmUs = non_pawn_material(board, c);
+        const int npmThem = non_pawn_material(board, c ^ 1);
+        int scale = SCALE_NORMAL;
+        if (npmUs - npmThem <= PIECE_VALUES[BISHOP]) {
+            if (count(board, PAWN, c) == 0) {
+                scale = npmUs < PIECE_VALUES[ROOK] ? 0 : (npmThem <= PIECE_VALUES[BISHOP] ? 4 : 14);
+            } else if (count(board, PAWN, c) == 1) {
+                scale = SCALE_ONE_PAWN;
+            }
+        }
+        e.scale[c] = static_cast<uint8_t>(scale);
+    }
+
+    e.bishopsOnly = count(board, BISHOP, WHITE) == 1 && count(board, BISHOP, BLACK) == 1 &&
+                    non_pawn_material(board, WHITE) == PIECE_VALUES[BISHOP] &&
+                    non_pawn_material(board, BLACK) == PIECE_VALUES[BISHOP];
+}
+
+} // namespace
+
+MaterialTable::MaterialTable() : entries(SIZE) {
+    clear();
+}
+
+void MaterialTable::clear() {
+    // Key 0 is never a real position (both kings are always counted)
+    for (MaterialEntry& e : entries) e = MaterialEntry{};
+}
+
+const MaterialEntry& probe_material(const Board& board, MaterialTable& table) {
+    MaterialEntry& entry = table.entries[board.materialKey & (MaterialTable::SIZE - 1)];
+    if (entry.key == board.materialKey) return entry;
+
+    entry.key = board.materialKey;
+    compute_entry(board, entry);
+    return entry;
+}
@@ -0,0 +1,33 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include "board.h"
+#include "endgame.h"
+#include <vector>
+
+inline constexpr int SCALE_NORMAL = 64; // Endgame scale factors are in 1/64ths
+
+// Everything the evaluation derives from piece counts alone, cached under Board::materialKey.
+struct MaterialEntry {
+    uint64_t key;
+    int imbalance;          // Packed mg/eg (see make_score), white minus black
+    EndgameFn evalFn;       // Specialised evaluator replacing the whole eval, or nullptr
+    uint8_t strongSide;     // Side evalFn scores for
+    uint8_t gamePhase;      // 0 (pawn endgame) .. 24
+    uint8_t scale[2];       // Endgame scale when that colour is ahead
+    bool bishopsOnly;       // One bishop each and pawns: scaled down further if the bishops are on opposite colours
+};
+
+// Owned by a single search thread, like PawnTable. Direct-mapped, always replace.
+struct MaterialTable {
+    static constexpr size_t SIZE = 1 << 13; // Power of two
+
+    std::vector<MaterialEntry> entries;
+
+    MaterialTable();
+    void clear();
+};
+
+const MaterialEntry& probe_material(const Board& board, MaterialTable& table);
+
+#endif
@@ -1,40 +1,23 @@
 #include "board.h"
 #include "bitboard.h"
+#include "attacks.h"
 #include "types.h"
 
-#include <vector>
+#include <cassert>
 
 namespace {
 
-inline void push_move(std::vector<Move>& moves, int fromSq, int toSq, int capturedPiece = 0, int promotion = 0, bool isEnPassant = false, bool isCastling = false, int pieceType = 0) {
-    Move m;
-    m.fromRow = sq_to_row(fromSq);
-    m.fromCol = sq_to_col(fromSq);
-    m.toRow = sq_to_row(toSq);
-    m.toCol = sq_to_col(toSq);
-    m.capturedPiece = capturedPiece;
-    m.promotion = promotion;
-    m.isEnPassant = isEnPassant;
-    m.isCastling = isCastling;
-    m.pieceType = pieceType;
-    moves.push_back(m);
+// Which subset of legal moves a generator emits.
+enum GenType { GEN_ALL, GEN_CAPTURES, GEN_QUIETS };
+
+inline void push_move(MoveList& moves, int fromSq, int toSq, MoveType type = MOVE_NORMAL, int promotion = KNIGHT) {
+    moves.push_back(Move(fromSq, toSq, type, promotion));
 }
 
-inline int piece_on_square_bb(const Board& board, int sq) {
-    Bitboard mask = 1ULL << sq;
-    if (board.color[WHITE] & mask) {
-        for (int i = 0; i < 6; i++) {
-            if (board.piece[i] & mask) return i + 1;  // W_PAWN=1 to W_KING=6
-        }
-        return 0;
-    }
-    if (board.color[BLACK] & mask) {
-        for (int i = 0; i < 6; i++) {
-            if (board.piece[i] & mask) return i + 7;  // B_PAWN=7 to B_KING=12
-        }
-        return 0;
+inline void push_promotions(MoveList& moves, int fromSq, int toSq) {
+    for (int promo : {QUEEN, ROOK, BISHOP, KNIGHT}) {
+        push_move(moves, fromSq, toSq, MOVE_PROMOTION, promo);
     }
-    return 0;
 }
 
 inline bool is_king_piece(int piece) {
@@ -71,215 +54,161 @@ inline bool is_square_attacked_bb(const Board& board, int sq, bool byWhite) {
     return false;
 }
 
+// Destination squares allowed for non-pawn, non-king moves of the given generation type.
+template <GenType Type>
+inline Bitboard target_mask(const AttackInfo& info) {
+    if constexpr (Type == GEN_CAPTURES) return info.opp & info.checkMask;
+    else if constexpr (Type == GEN_QUIETS) return ~info.occ & info.checkMask;
+    else return ~info.own & info.checkMask;
+}
+
+// A pinned piece may only move along the line through its king.
+inline Bitboard pin_mask(const AttackInfo& info, int from) {
+    return (info.pinned & (1ULL << from)) ? line_bb[info.kingSq][from] : ~0ULL;
+}
+
+// En passant removes two pieces from one rank, so it gets a full attack test.
+inline bool en_passant_is_legal(const Board& board, const AttackInfo& info, int from, int to, int capSq) {
+    Bitboard occ = (info.occ ^ (1ULL << from) ^ (1ULL << capSq)) | (1ULL << to);
+    return (attackers_to(board, info.kingSq, occ) & info.opp & ~(1ULL << capSq)) == 0;
+}
+
 } // namespace
 
-void generate_pawn_moves_bb(const Board& board, std::vector<Move>& moves) {
+template <GenType Type>
+void generate_pawn_moves_bb(const Board& board, const AttackInfo& info, MoveList& moves) {
     const bool whiteToMove = board.isWhiteTurn;
-    const int us = whiteToMove ? WHITE : BLACK;
+    const int us = info.us;
 
-    Bitboard own = board.color[us];
-    Bitboard opp = board.color[whiteToMove ? BLACK : WHITE];
-    Bitboard pawns = board.piece[PAWN - 1] & own;
-    Bitboard empty = ~(own | opp);
+    Bitboard pawns = board.piece[PAWN - 1] & info.own;
+    Bitboard empty = ~info.occ;
 
     while (pawns) {
         int from = lsb(pawns);
         pawns &= pawns - 1;
+        const Bitboard allowed = pin_mask(info, from) & info.checkMask;
 
         int to = whiteToMove ? (from + 8) : (from - 8);
-        if (to >= 0 && to < 64) {
+        if (Type != GEN_CAPTURES && to >= 0 && to < 64) {
             Bitboard toMask = 1ULL << to;
             if (empty & toMask) {
                 bool isPromo = whiteToMove ? (from >= 48) : (from <= 15);
                 if (isPromo) {
-                    for (int promo : {QUEEN, ROOK, BISHOP, KNIGHT}) {
-                        push_move(moves, from, to, 0, promo, false, false, PAWN);
+                    if (allowed & toMask) {
+                        push_promotions(moves, from, to);
                     }
                 } else {
-                    push_move(moves, from, to, 0, 0, false, false, PAWN);
+                    if (allowed & toMask) {
+                        push_move(moves, from, to);
+                    }
                     bool onStartRank = whiteToMove ? (from >= 8 && from <= 15) : (from >= 48 && from <= 55);
                     if (onStartRank) {
                         int to2 = whiteToMove ? (from + 16) : (from - 16);
                         Bitboard to2Mask = 1ULL << to2;
-                        if (empty & to2Mask) {
-                            push_move(moves, from, to2, 0, 0, false, false, PAWN);
+                        if ((empty & to2Mask) && (allowed & to2Mask)) {
+                            push_move(moves, from, to2);
                         }
                     }
                 }
             }
         }
 
-        Bitboard attacks = pawn_attacks[us][from] & opp;
+        if constexpr (Type == GEN_QUIETS) continue;
+
+        Bitboard attacks = pawn_attacks[us][from] & info.opp & allowed;
         while (attacks) {
             int capSq = lsb(attacks);
             attacks &= attacks - 1;
-            int captured = piece_on_square_bb(board, capSq);
-            if (is_king_piece(captured)) continue;
+            if (is_king_piece(board.mailbox[capSq])) continue;
             bool isPromo = whiteToMove ? (capSq >= 56) : (capSq <= 7);
             if (isPromo) {
-                for (int promo : {QUEEN, ROOK, BISHOP, KNIGHT}) {
-                    push_move(moves, from, capSq, captured, promo, false, false, PAWN);
-                }
+                push_promotions(moves, from, capSq);
             } else {
-                push_move(moves, from, capSq, captured, 0, false, false, PAWN);
+                push_move(moves, from, capSq);
             }
         }
 
         if (board.enPassantCol != -1) {
             int epRow = whiteToMove ? 2 : 5;
             int epSq = row_col_to_sq(epRow, board.enPassantCol);
-            if (pawn_attacks[us][from] & (1ULL << epSq)) {
-                int captured = whiteToMove ? B_PAWN : W_PAWN;
-                push_move(moves, from, epSq, captured, 0, true, false, PAWN);
+            int capSq = whiteToMove ? epSq - 8 : epSq + 8;
+            if ((pawn_attacks[us][from] & (1ULL << epSq)) && en_passant_is_legal(board, info, from, epSq, capSq)) {
+                push_move(moves, from, epSq, MOVE_EN_PASSANT);
             }
         }
     }
 }
 
-void generate_knight_moves_bb(const Board& board, std::vector<Move>& moves) {
-    const bool whiteToMove = board.isWhiteTurn;
-    const int us = whiteToMove ? WHITE : BLACK;
-    const int them = whiteToMove ? BLACK : WHITE;
-
-    Bitboard own = board.color[us];
-    Bitboard opp = board.color[them];
-    Bitboard knights = board.piece[KNIGHT - 1] & own;
-
-    while (knights) {
-        int from = lsb(knights);
-        knights &= knights - 1;
-
-        Bitboard targets = knight_attacks[from] & ~own;
-        while (targets) {
-            int to = lsb(targets);
-            targets &= targets - 1;
-            int captured = (opp & (1ULL << to)) ? piece_on_square_bb(board, to) : 0;
-            if (is_king_piece(captured)) continue;
-            push_move(moves, from, to, captured, 0, false, false, KNIGHT);
-        }
-    }
-}
-
-void generate_bishop_moves_bb(const Board& board, std::vector<Move>& moves) {
-    const bool whiteToMove = board.isWhiteTurn;
-    const int us = whiteToMove ? WHITE : BLACK;
-    const int them = whiteToMove ? BLACK : WHITE;
-
-    Bitboard own = board.color[us];
-    Bitboard opp = board.color[them];
-    Bitboard bishops = board.piece[BISHOP - 1] & own;
-    Bitboard occ = board_occupancy(board);
-
-    while (bishops) {
-        int from = lsb(bishops);
-        bishops &= bishops - 1;
-
-        Bitboard targets = get_bishop_attacks(from, occ) & ~own;
-        while (targets) {
-            int to = lsb(targets);
-            targets &= targets - 1;
-            int captured = (opp & (1ULL << to)) ? piece_on_square_bb(board, to) : 0;
-            if (is_king_piece(captured)) continue;
-            push_move(moves, from, to, captured, 0, false, false, BISHOP);
-        }
-    }
-}
-
-void generate_rook_moves_bb(const Board& board, std::vector<Move>& moves) {
-    const bool whiteToMove = board.isWhiteTurn;
-    const int us = whiteToMove ? WHITE : BLACK;
-    const int them = whiteToMove ? BLACK : WHITE;
-
-    Bitboard own = board.color[us];
-    Bitboard opp = board.color[them];
-    Bitboard rooks = board.piece[ROOK - 1] & own;
-    Bitboard occ = board_occupancy(board);
-
-    while (rooks) {
-        int from = lsb(rooks);
-        rooks &= rooks - 1;
-
-        Bitboard targets = get_rook_attacks(from, occ) & ~own;
-        while (targets) {
-            int to = lsb(targets);
-            targets &= targets - 1;
-            int captured = (opp & (1ULL << to)) ? piece_on_square_bb(board, to) : 0;
-            if (is_king_piece(captured)) continue;
-            push_move(moves, from, to, captured, 0, false, false, ROOK);
+// Knights, bishops, rooks and queens.
+template <GenType Type>
+void generate_piece_moves_bb(const Board& board, const AttackInfo& info, int pieceType, MoveList& moves) {
+    Bitboard pieces = board.piece[pieceType - 1] & info.own;
+    const Bitboard targetsMask = target_mask<Type>(info);
+
+    while (pieces) {
+        int from = lsb(pieces);
+        pieces &= pieces - 1;
+
+        Bitboard attacks = 0ULL;
+        switch (pieceType) {
+            case KNIGHT: attacks = knight_attacks[from]; break;
+            case BISHOP: attacks = get_bishop_attacks(from, info.occ); break;
+            case ROOK:   attacks = get_rook_attacks(from, info.occ); break;
+            case QUEEN:  attacks = get_bishop_attacks(from, info.occ) | get_rook_attacks(from, info.occ); break;
+            default: break;
         }
-    }
-}
 
-void generate_queen_moves_bb(const Board& board, std::vector<Move>& moves) {
-    const bool whiteToMove = board.isWhiteTurn;
-    const int us = whiteToMove ? WHITE : BLACK;
-    const int them = whiteToMove ? BLACK : WHITE;
-
-    Bitboard own = board.color[us];
-    Bitboard opp = board.color[them];
-    Bitboard queens = board.piece[QUEEN - 1] & own;
-    Bitboard occ = board_occupancy(board);
-
-    while (queens) {
-        int from = lsb(queens);
-        queens &= queens - 1;
-
-        Bitboard targets = (get_bishop_attacks(from, occ) | get_rook_attacks(from, occ)) & ~own;
+        Bitboard targets = attacks & targetsMask & pin_mask(info, from);
         while (targets) {
             int to = lsb(targets);
             targets &= targets - 1;
-            int captured = (opp & (1ULL << to)) ? piece_on_square_bb(board, to) : 0;
-            if (is_king_piece(captured)) continue;
-            push_move(moves, from, to, captured, 0, false, false, QUEEN);
+            if (is_king_piece(board.mailbox[to])) continue;
+            push_move(moves, from, to);
         }
     }
 }
 
-void generate_king_moves_bb(const Board& board, std::vector<Move>& moves) {
+template <GenType Type>
+void generate_king_moves_bb(const Board& board, const AttackInfo& info, MoveList& moves) {
     const bool whiteToMove = board.isWhiteTurn;
-    const int us = whiteToMove ? WHITE : BLACK;
-    const int them = whiteToMove ? BLACK : WHITE;
 
-    Bitboard own = board.color[us];
-    Bitboard opp = board.color[them];
-    Bitboard kings = board.piece[KING - 1] & own;
+    Bitboard kings = board.piece[KING - 1] & info.own;
     if (!kings) return;
 
-    int from = lsb(kings);
+    int from = info.kingSq;
+
+    Bitboard targets = king_attacks[from] & ~info.kingDanger;
+    if constexpr (Type == GEN_CAPTURES) targets &= info.opp;
+    else if constexpr (Type == GEN_QUIETS) targets &= ~info.occ;
+    else targets &= ~info.own;
 
-    Bitboard targets = king_attacks[from] & ~own;
     while (targets) {
         int to = lsb(targets);
         targets &= targets - 1;
-        int captured = (opp & (1ULL << to)) ? piece_on_square_bb(board, to) : 0;
-        if (is_king_piece(captured)) continue;
-        push_move(moves, from, to, captured, 0, false, false, KING);
+        if (is_king_piece(board.mailbox[to])) continue;
+        push_move(moves, from, to);
     }
 
-    Bitboard occ = board_occupancy(board);
-    const bool opponentIsWhite = !whiteToMove;
+    if constexpr (Type == GEN_CAPTURES) return;
+    if (info.checkers) return;
+
+    const Bitboard occ = info.occ;
+    const Bitboard danger = info.kingDanger;
 
     if (whiteToMove && from == 4) {
         if (board.whiteCanCastleKingSide) {
             const Bitboard emptyMask = (1ULL << 5) | (1ULL << 6);
             const bool rookPresent = (board.piece[ROOK - 1] & board.color[WHITE]) & (1ULL << 7);
-            if ((occ & emptyMask) == 0 &&
-                !is_square_attacked_bb(board, 4, opponentIsWhite) &&
-                !is_square_attacked_bb(board, 5, opponentIsWhite) &&
-                !is_square_attacked_bb(board, 6, opponentIsWhite) &&
-                rookPresent) {
-                push_move(moves, 4, 6, 0, 0, false, true, KING);
+            if ((occ & emptyMask) == 0 && (danger & emptyMask) == 0 && rookPresent) {
+                push_move(moves, 4, 6, MOVE_CASTLING);
             }
         }
         if (board.whiteCanCastleQueenSide) {
             const Bitboard emptyMask = (1ULL << 1) | (1ULL << 2) | (1ULL << 3);
+            const Bitboard safeMask = (1ULL << 2) | (1ULL << 3);
             const bool rookPresent = (board.piece[ROOK - 1] & board.color[WHITE]) & (1ULL << 0);
-            if ((occ & emptyMask) == 0 &&
-                !is_square_attacked_bb(board, 4, opponentIsWhite) &&
-                !is_square_attacked_bb(board, 3, opponentIsWhite) &&
-                !is_square_attacked_bb(board, 2, opponentIsWhite) &&
-                rookPresent) {
-                push_move(moves, 4, 2, 0, 0, false, true, KING);
+            if ((occ & emptyMask) == 0 && (danger & safeMask) == 0 && rookPresent) {
+                push_move(moves, 4, 2, MOVE_CASTLING);
             }
         }
     }
@@ -288,23 +217,16 @@ void generate_king_moves_bb(const Board& board, std::vector<Move>& moves) {
         if (board.blackCanCastleKingSide) {
             const Bitboard emptyMask = (1ULL << 61) | (1ULL << 62);
             const bool rookPresent = (board.piece[ROOK - 1] & board.color[BLACK]) & (1ULL << 63);
-            if ((occ & emptyMask) == 0 &&
-                !is_square_attacked_bb(board, 60, opponentIsWhite) &&
-                !is_square_attacked_bb(board, 61, opponentIsWhite) &&
-                !is_square_attacked_bb(board, 62, opponentIsWhite) &&
-                rookPresent) {
-                push_move(moves, 60, 62, 0, 0, false, true, KING);
+            if ((occ & emptyMask) == 0 && (danger & emptyMask) == 0 && rookPresent) {
+                push_move(moves, 60, 62, MOVE_CASTLING);
             }
         }
         if (board.blackCanCastleQueenSide) {
             const Bitboard emptyMask = (1ULL << 57) | (1ULL << 58) | (1ULL << 59);
+            const Bitboard safeMask = (1ULL << 58) | (1ULL << 59);
             const bool rookPresent = (board.piece[ROOK - 1] & board.color[BLACK]) & (1ULL << 56);
-            if ((occ & emptyMask) == 0 &&
-                !is_square_attacked_bb(board, 60, opponentIsWhite) &&
-                !is_square_attacked_bb(board, 59, opponentIsWhite) &&
-                !is_square_attacked_bb(board, 58, opponentIsWhite) &&
-                rookPresent) {
-                push_move(moves, 60, 58, 0, 0, false, true, KING);
+            if ((occ & emptyMask) == 0 && (danger & safeMask) == 0 && rookPresent) {
+                push_move(moves, 60, 58, MOVE_CASTLING);
             }
         }
     }
@@ -315,54 +237,166 @@ bool is_square_attacked(const Board& board, int row, int col, bool isWhiteAttack
     return is_square_attacked_bb(board, sq, isWhiteAttacker);
 }
 
-std::vector<Move> get_all_moves(Board& board, bool isWhiteTurn) {
-    std::vector<Move> pseudoMoves;
-    std::vector<Move> legalMoves;
-    pseudoMoves.reserve(256);
-    (void)isWhiteTurn;
-    const bool sideToMove = board.isWhiteTurn;
-
-    generate_pawn_moves_bb(board, pseudoMoves);
-    generate_knight_moves_bb(board, pseudoMoves);
-    generate_bishop_moves_bb(board, pseudoMoves);
-    generate_rook_moves_bb(board, pseudoMoves);
-    generate_queen_moves_bb(board, pseudoMoves);
-    generate_king_moves_bb(board, pseudoMoves);
-
-    for (auto& m : pseudoMoves) {
-        board.makeMove(m);
-        int kingRow = 0;
-        int kingCol = 0;
-        if (!king_square(board, sideToMove, kingRow, kingCol)) {
-            board.unmakeMove(m);
-            continue;
-        }
-        if (!is_square_attacked(board, kingRow, kingCol, !sideToMove)) {
-            legalMoves.push_back(m);
+namespace {
+
+template <GenType Type>
+void generate_moves(const Board& board, const AttackInfo& info, MoveList& moves) {
+    // In double check only king moves are legal.
+    if (info.checkMask != 0) {
+        generate_pawn_moves_bb<Type>(board, info, moves);
+        for (int pieceType = KNIGHT; pieceType <= QUEEN; pieceType++) {
+            generate_piece_moves_bb<Type>(board, info, pieceType, moves);
         }
-        board.unmakeMove(m);
     }
+    generate_king_moves_bb<Type>(board, info, moves);
+}
 
-    return legalMoves;
+template <GenType Type>
+void generate_moves(const Board& board, MoveList& moves) {
+    AttackInfo info;
+    compute_attack_info(board, info);
+    generate_moves<Type>(board, info, moves);
 }
 
-std::vector<Move> get_capture_moves(const Board& board) {
-    std::vector<Move> moves;
-    std::vector<Move> pseudoMoves;
-    pseudoMoves.reserve(128);
-
-    generate_pawn_moves_bb(board, pseudoMoves);
-    generate_knight_moves_bb(board, pseudoMoves);
-    generate_bishop_moves_bb(board, pseudoMoves);
-    generate_rook_moves_bb(board, pseudoMoves);
-    generate_queen_moves_bb(board, pseudoMoves);
-    generate_king_moves_bb(board, pseudoMoves);
-
-    for (auto& m : pseudoMoves) {
-        if (is_capture(m)) {
-            moves.push_back(m);
+} // namespace
+
+void get_all_moves(Board& board, MoveList& moves) {
+    moves.clear();
+    generate_moves<GEN_ALL>(board, moves);
+}
+
+void get_capture_moves(const Board& board, MoveList& moves) {
+    generate_moves<GEN_CAPTURES>(board, moves);
+}
+
+void get_quiet_moves(const Board& board, MoveList& moves) {
+    generate_moves<GEN_QUIETS>(board, moves);
+}
+
+void get_capture_moves(const Board& board, const AttackInfo& info, MoveList& moves) {
+    generate_moves<GEN_CAPTURES>(board, info, moves);
+}
+
+void get_quiet_moves(const Board& board, const AttackInfo& info, MoveList& moves) {
+    generate_moves<GEN_QUIETS>(board, info, moves);
+}
+
+bool is_pseudo_legal(const Board& board, const Move& move) {
+    if (move.is_none()) return false;
+    const int fromSq = move.from_sq();
+    const int toSq = move.to_sq();
+    const int piece = board.mailbox[fromSq];
+    if (piece == 0 || piece_color(piece) != side_to_move(board)) return false;
+
+    const int us = piece_color(piece);
+    const Bitboard own = board.color[us];
+    const Bitboard opp = board.color[other_color(us)];
+    const Bitboard occ = own | opp;
+    const Bitboard toMask = 1ULL << toSq;
+    const int captured = board.mailbox[toSq];
+    if ((own & toMask) || is_king_piece(captured)) return false;
+
+    const int pt = piece_type(piece);
+    const MoveType type = move.type();
+
+    if (type == MOVE_CASTLING) {
+        // Let the generator validate rights, path and attacked squares.
+        if (pt != KING) return false;
+        AttackInfo info;
+        compute_attack_info(board, info);
+        MoveList kingMoves;
+        generate_king_moves_bb<GEN_QUIETS>(board, info, kingMoves);
+        for (const Move& km : kingMoves) {
+            if (km == move) return true;
         }
+        return false;
     }
+    if (pt != PAWN && type != MOVE_NORMAL) return false;
+
+    switch (pt) {
+        case PAWN: {
+            const bool white = (us == WHITE);
+            const int push = white ? 8 : -8;
+            const bool lastRank = white ? (toSq >= 56) : (toSq <= 7);
+            if (lastRank != (type == MOVE_PROMOTION)) return false;
+
+            if (pawn_attacks[us][fromSq] & toMask) {
+                if (type == MOVE_EN_PASSANT) {
+                    return board.enPassantCol != -1 && toSq == row_col_to_sq(white ? 2 : 5, board.enPassantCol);
+                }
+                return captured != 0;
+            }
+            if (captured != 0 || type == MOVE_EN_PASSANT) return false;
+            if (toSq == fromSq + push) return true;
+            const bool onStartRank = white ? (fromSq >= 8 && fromSq <= 15) : (fromSq >= 48 && fromSq <= 55);
+            return onStartRank && toSq == fromSq + 2 * push && !(occ & (1ULL << (fromSq + push)));
+        }
+        case KNIGHT:
+            return knight_attacks[fromSq] & toMask;
+        case BISHOP:
+            return get_bishop_attacks(fromSq, occ) & toMask;
+        case ROOK:
+            return get_rook_attacks(fromSq, occ) & toMask;
+        case QUEEN:
+            return (get_bishop_attacks(fromSq, occ) | get_rook_attacks(fromSq, occ)) & toMask;
+        case KING:
+            return king_attacks[fromSq] & toMask;
+        default:
+            return false;
+    }
+}
 
-    return moves;
+bool is_legal(const Board& board, const Move& move) {
+    const int us = side_to_move(board);
+    const int them = other_color(us);
+    const Bitboard king = board.piece[KING - 1] & board.color[us];
+    if (!king) return false;
+    const int kingSq = lsb(king);
+    const int fromSq = move.from_sq();
+    const int toSq = move.to_sq();
+    const Bitboard occ = board_occupancy(board);
+
+    // Castling moves are only produced by the generator, which already checks the path.
+    if (move.is_castling()) return true;
+
+    if (fromSq == kingSq) {
+        Bitboard occAfter = (occ ^ king) | (1ULL << toSq);
+        return (attackers_to(board, toSq, occAfter) & board.color[them] & ~(1ULL << toSq)) == 0;
+    }
+
+    if (move.is_en_passant()) {
+        int capSq = (us == WHITE) ? toSq - 8 : toSq + 8;
+        Bitboard occAfter = (occ ^ (1ULL << fromSq) ^ (1ULL << capSq)) | (1ULL << toSq);
+        return (attackers_to(board, kingSq, occAfter) & board.color[them] & ~(1ULL << capSq)) == 0;
+    }
+
+    const Bitboard checkers = attackers_to(board, kingSq, occ) & board.color[them];
+    if (checkers) {
+        if (checkers & (checkers - 1)) return false;
+        if (!((checkers | between_bb[kingSq][lsb(checkers)]) & (1ULL << toSq))) return false;
+    }
+
+    // Not pinned, or moving along the pin line.
+    Bitboard occAfter = (occ ^ (1ULL << fromSq)) | (1ULL << toSq);
+    Bitboard sliders = ((get_bishop_attacks(kingSq, occAfter) & (board.piece[BISHOP - 1] | board.piece[QUEEN - 1])) |
+                        (get_rook_attacks(kingSq, occAfter) & (board.piece[ROOK - 1] | board.piece[QUEEN - 1])));
+    return (sliders & board.color[them] & ~(1ULL << toSq)) == 0;
+}
+
+bool is_legal(const Board& board, const Move& move, const AttackInfo& info) {
+    if (!(board.piece[KING - 1] & info.own)) return false;
+    if (move.is_castling()) return true;
+
+    const int fromSq = move.from_sq();
+    const int toSq = move.to_sq();
+    if (fromSq == info.kingSq) {
+        assert(!(info.kingDanger & (1ULL << toSq)) == is_legal(board, move));
+        return !(info.kingDanger & (1ULL << toSq));
+    }
+    if (move.is_en_passant()) {
+        return en_passant_is_legal(board, info, fromSq, toSq, info.us == WHITE ? toSq - 8 : toSq + 8);
+    }
+    const bool legal = (info.checkMask & pin_mask(info, fromSq) & (1ULL << toSq)) != 0;
+    assert(legal == is_legal(board, move));
+    return legal;
 }
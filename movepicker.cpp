@@ -0,0 +1,181 @@
+#include "movepicker.h"
+#include "evaluation.h"
+
+namespace {
+
+const int SEE_GOOD_CAPTURE_THRESHOLD = -82; // ~minus pawn, same as scoreMove
+
+int mvv_lva(const Board& board, const Move& move) {
+    int victimPiece = piece_type(captured_piece(board, move));
+    int attackerPiece = piece_type(piece_at_sq(board, move.from_sq()));
+    return PIECE_VALUES[victimPiece] * 10 - PIECE_VALUES[attackerPiece];
+}
+
+int quiet_score(const SearchHistory& history, const Move& move) {
+    int score = get_history_score(history, move.from_sq(), move.to_sq());
+
+    switch (move.promotion()) {
+        case QUEEN: score += SCORE_PROMO_QUEEN; break;
+        case ROOK: score += SCORE_PROMO_ROOK; break;
+        case BISHOP: score += SCORE_PROMO_BISHOP; break;
+        case KNIGHT: score += SCORE_PROMO_KNIGHT; break;
+        default: break;
+    }
+
+    if (move.is_castling()) {
+        score += 500;
+    }
+    return score;
+}
+
+} // namespace
+
+MovePicker::MovePicker(const Board& board, const AttackInfo& info, const SearchHistory& history, const Move* tt, int ply)
+    : board(board), info(info), history(history), ply(ply), capturesOnly(false), quietChecks(false), pruneLosing(false), stage(STAGE_TT) {
+    if (tt != nullptr) {
+        ttMove = *tt;
+        hasTTMove = true;
+    }
+    killers[0] = get_killer_move(history, 0, ply);
+    killers[1] = get_killer_move(history, 1, ply);
+}
+
+MovePicker::MovePicker(const Board& board, const AttackInfo& info, const SearchHistory& history, const Move* tt, bool quietChecks, bool pruneLosing)
+    : board(board), info(info), history(history), ply(-1), capturesOnly(true), quietChecks(quietChecks),
+      pruneLosing(pruneLosing), stage(STAGE_TT) {
+    // A quiet TT move is left to the quiet-check stage, which tests it like any other move
+    if (tt != nullptr && is_capture(board, *tt)) {
+        ttMove = *tt;
+        hasTTMove = true;
+    }
+}
+
+int MovePicker::pick_best(int end) {
+    int best = cur;
+    for (int i = cur + 1; i < end; i++) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    std::swap(moves[cur], moves[best]);
+    std::swap(scores[cur], scores[best]);
+    return cur++;
+}
+
+bool MovePicker::is_special(const Move& move) const {
+    if (hasTTMove && moves_equal(move, ttMove)) return true;
+    if (capturesOnly) return false;
+    return moves_equal(move, killers[0]) || moves_equal(move, killers[1]);
+}
+
+bool MovePicker::next(Move& move) {
+    switch (stage) {
+        case STAGE_TT:
+            stage = STAGE_GEN_CAPTURES;
+            if (hasTTMove) {
+                if (is_pseudo_legal(board, ttMove) && is_legal(board, ttMove, info) &&
+                    (!pruneLosing || staticExchangeEvaluation(board, ttMove, 0))) {
+                    move = ttMove;
+                    return true;
+                }
+                hasTTMove = false;
+            }
+            [[fallthrough]];
+
+        case STAGE_GEN_CAPTURES:
+            get_capture_moves(board, info, moves);
+            captureEnd = moves.size();
+            for (int i = 0; i < captureEnd; i++) {
+                scores[i] = mvv_lva(board, moves[i]);
+            }
+            stage = STAGE_GOOD_CAPTURES;
+            [[fallthrough]];
+
+        case STAGE_GOOD_CAPTURES:
+            while (cur < captureEnd) {
+                const Move& m = moves[pick_best(captureEnd)];
+                // Only the TT move was returned already: the killer stage never returns captures
+                if (hasTTMove && moves_equal(m, ttMove)) continue;
+                // SEE only for captures we actually reach; losers are parked for the last stage.
+                if (pruneLosing) {
+                    if (!staticExchangeEvaluation(board, m, 0)) continue;
+                } else if (!staticExchangeEvaluation(board, m, SEE_GOOD_CAPTURE_THRESHOLD)) {
+                    moves[badEnd++] = m;
+                    continue;
+                }
+                move = m;
+                return true;
+            }
+            if (capturesOnly) {
+                stage = quietChecks ? STAGE_GEN_QUIET_CHECKS : STAGE_BAD_CAPTURES;
+                return next(move);
+            }
+            stage = STAGE_KILLER_1;
+            [[fallthrough]];
+
+        case STAGE_KILLER_1:
+        case STAGE_KILLER_2:
+            while (stage == STAGE_KILLER_1 || stage == STAGE_KILLER_2) {
+                const Move& killer = killers[stage - STAGE_KILLER_1];
+                stage++;
+                if (hasTTMove && moves_equal(killer, ttMove)) continue;
+                if (is_pseudo_legal(board, killer) && !is_capture(board, killer) && is_legal(board, killer, info)) {
+                    move = killer;
+                    return true;
+                }
+            }
+            [[fallthrough]];
+
+        case STAGE_GEN_QUIETS:
+            // Quiets overwrite the consumed capture slots after the parked bad captures.
+            moves.count = badEnd;
+            cur = badEnd;
+            get_quiet_moves(board, info, moves);
+            for (int i = cur; i < moves.size(); i++) {
+                scores[i] = quiet_score(history, moves[i]);
+            }
+            stage = STAGE_QUIETS;
+            [[fallthrough]];
+
+        case STAGE_QUIETS:
+            while (cur < moves.size()) {
+                const Move& m = moves[pick_best(moves.size())];
+                if (!is_special(m)) {
+                    move = m;
+                    return true;
+                }
+            }
+            stage = STAGE_BAD_CAPTURES;
+            [[fallthrough]];
+
+        case STAGE_BAD_CAPTURES:
+            // Already in MVV-LVA order from the good-capture stage.
+            while (badCur < badEnd) {
+                move = moves[badCur++];
+                return true;
+            }
+            stage = STAGE_DONE;
+            return false;
+
+        case STAGE_GEN_QUIET_CHECKS:
+            // Same slots as the quiet stage; checks are rare, so they are tested in generation order.
+            moves.count = badEnd;
+            cur = badEnd;
+            get_quiet_moves(board, info, moves);
+            stage = STAGE_QUIET_CHECKS;
+            [[fallthrough]];
+
+        case STAGE_QUIET_CHECKS:
+            while (cur < moves.size()) {
+                const Move& m = moves[cur++];
+                if (!is_special(m) && gives_check(board, m) &&
+                    (!pruneLosing || staticExchangeEvaluation(board, m, 0))) {
+                    move = m;
+                    return true;
+                }
+            }
+            stage = STAGE_BAD_CAPTURES;
+            return next(move);
+
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef MOVEPICKER_H
+#define MOVEPICKER_H
+
+#include "attacks.h"
+#include "board.h"
+#include "history.h"
+
+// Staged move picker. Moves are generated and scored only when the previous
+// stage is exhausted, so a node that cuts off on the TT move never generates
+// anything, and every move is scored exactly once.
+//
+// Main search order: TT move, good captures, killer 1, killer 2, quiets, bad captures.
+// Quiescence order:  TT move (if a capture), good captures, quiet checks (optional), bad captures.
+// With pruneLosing, quiescence skips every move that loses material by SEE instead, so
+// there is no bad-capture stage and callers need no SEE of their own.
+//
+// Every move returned by next(): generated moves come from the legal generator,
+// the TT move and killers are checked with is_legal(). Generation and legality use the
+// node's AttackInfo, which must outlive the picker.
+class MovePicker {
+public:
+    MovePicker(const Board& board, const AttackInfo& info, const SearchHistory& history, const Move* ttMove, int ply);
+    MovePicker(const Board& board, const AttackInfo& info, const SearchHistory& history, const Move* ttMove, bool quietChecks, bool pruneLosing);
+
+    // Returns false once all stages are exhausted.
+    bool next(Move& move);
+
+private:
+    enum Stage {
+        STAGE_TT,
+        STAGE_GEN_CAPTURES,
+        STAGE_GOOD_CAPTURES,
+        STAGE_KILLER_1,
+        STAGE_KILLER_2,
+        STAGE_GEN_QUIETS,
+        STAGE_QUIETS,
+        STAGE_BAD_CAPTURES,
+        STAGE_GEN_QUIET_CHECKS,
+        STAGE_QUIET_CHECKS,
+        STAGE_DONE
+    };
+
+    // Selection sort step: swap the best entry in [cur, end) to `cur` and return its index.
+    int pick_best(int end);
+
+    bool is_special(const Move& move) const; // Already returned by the TT or killer stage
+
+    const Board& board;
+    const AttackInfo& info;
+    const SearchHistory& history;
+    int ply;
+    bool capturesOnly;
+    bool quietChecks;     // Quiescence only: also try quiet moves that give check
+    bool pruneLosing;     // Quiescence only: drop moves with SEE < 0 rather than parking them
+    int stage;
+
+    Move ttMove;
+    Move killers[2];
+    bool hasTTMove = false;
+
+    // Layout of `moves`: [0, badEnd) bad captures parked while picking,
+    // [cur, captureEnd) captures still to pick, then quiets up to moves.count.
+    MoveList moves;
+    int scores[MAX_MOVES];
+    int cur = 0;
+    int captureEnd = 0;
+    int badEnd = 0;
+    int badCur = 0;
+};
+
+#endif
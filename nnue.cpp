@@ -0,0 +1,213 @@
+#include "nnue.h"
+#include "board.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define NNUE_X86 1
+#endif
+
+// GCC on Linux can clone the accumulator loops for AVX2 and pick one at load time.
+#if defined(NNUE_X86) && defined(__linux__) && defined(__GNUC__) && !defined(__clang__)
+#define NNUE_MULTIVERSION __attribute__((target_clones("avx2", "default")))
+#else
+#define NNUE_MULTIVERSION
+#endif
+
+namespace {
+
+struct Network {
+    alignas(64) int16_t featureWeights[NNUE_INPUTS][NNUE_HIDDEN];
+    alignas(64) int16_t featureBias[NNUE_HIDDEN];
+    alignas(64) int16_t outputWeights[2][NNUE_HIDDEN];
+    int32_t outputBias;
+};
+
+std::unique_ptr<Network> g_net;
+std::atomic<bool> g_enabled{false};
+
+inline int feature_index(int perspective, int piece, int sq) {
+    int c = piece_color(piece);
+    if (perspective == BLACK) {
+        c ^= 1;
+        sq ^= 56;
+    }
+    return c * 384 + (piece_type(piece) - 1) * 64 + sq;
+}
+
+// ---- Accumulator updates (plain loops; the compiler vectorises them) ----
+
+NNUE_MULTIVERSION
+void add_column(int16_t* acc, const int16_t* w) {
+    for (int i = 0; i < NNUE_HIDDEN; i++) acc[i] += w[i];
+}
+
+NNUE_MULTIVERSION
+void sub_column(int16_t* acc, const int16_t* w) {
+    for (int i = 0; i < NNUE_HIDDEN; i++) acc[i] -= w[i];
+}
+
+NNUE_MULTIVERSION
+void add_sub_column(int16_t* dst, const int16_t* src, const int16_t* add, const int16_t* sub) {
+    for (int i = 0; i < NNUE_HIDDEN; i++) dst[i] = static_cast<int16_t>(src[i] + add[i] - sub[i]);
+}
+
+void compute_accumulator(const Board& board, NNUEAccumulator& acc) {
+    for (int persp = WHITE; persp <= BLACK; persp++) {
+        std::memcpy(acc.values[persp], g_net->featureBias, sizeof(g_net->featureBias));
+        Bitboard occ = board.color[WHITE] | board.color[BLACK];
+        while (occ) {
+            int sq = lsb(occ);
+            occ &= occ - 1;
+            add_column(acc.values[persp], g_net->featureWeights[feature_index(persp, board.mailbox[sq], sq)]);
+        }
+    }
+}
+
+// ---- Output layer: sum(clamp(acc, 0, QA) * w) ----
+
+[[maybe_unused]] int32_t crelu_dot_scalar(const int16_t* acc, const int16_t* w) {
+    int32_t sum = 0;
+    for (int i = 0; i < NNUE_HIDDEN; i++) {
+        int v = acc[i] < 0 ? 0 : (acc[i] > NNUE_QA ? NNUE_QA : acc[i]);
+        sum += v * w[i];
+    }
+    return sum;
+}
+
+#ifdef NNUE_X86
+int32_t crelu_dot_sse2(const int16_t* acc, const int16_t* w) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i qa = _mm_set1_epi16(NNUE_QA);
+    __m128i sum = zero;
+    for (int i = 0; i < NNUE_HIDDEN; i += 8) {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(acc + i));
+        v = _mm_min_epi16(_mm_max_epi16(v, zero), qa);
+        sum = _mm_add_epi32(sum, _mm_madd_epi16(v, _mm_load_si128(reinterpret_cast<const __m128i*>(w + i))));
+    }
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+    return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("avx2")))
+int32_t crelu_dot_avx2(const int16_t* acc, const int16_t* w) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i qa = _mm256_set1_epi16(NNUE_QA);
+    __m256i sum = zero;
+    for (int i = 0; i < NNUE_HIDDEN; i += 16) {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(acc + i));
+        v = _mm256_min_epi16(_mm256_max_epi16(v, zero), qa);
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(v, _mm256_load_si256(reinterpret_cast<const __m256i*>(w + i))));
+    }
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4E));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xB1));
+    return _mm_cvtsi128_si32(s);
+}
+#endif
+
+using CreluDotFn = int32_t (*)(const int16_t*, const int16_t*);
+
+CreluDotFn select_crelu_dot() {
+#ifdef NNUE_X86
+    __builtin_cpu_init(); // Runs during static initialisation
+    if (__builtin_cpu_supports("avx2")) return crelu_dot_avx2;
+    return crelu_dot_sse2;
+#else
+    return crelu_dot_scalar;
+#endif
+}
+
+const CreluDotFn crelu_dot = select_crelu_dot();
+
+template <typename T>
+bool read_array(std::ifstream& in, T* data, size_t count) {
+    in.read(reinterpret_cast<char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+    return static_cast<bool>(in);
+}
+
+} // namespace
+
+int nnue_feature_index(int perspective, int piece, int sq) {
+    return feature_index(perspective, piece, sq);
+}
+
+bool nnue_load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    char magic[8];
+    uint32_t version = 0, hidden = 0;
+    in.read(magic, sizeof(magic));
+    if (!read_array(in, &version, 1) || !read_array(in, &hidden, 1)) return false;
+    if (std::memcmp(magic, NNUE_MAGIC, sizeof(magic)) != 0 || version != NNUE_VERSION || hidden != NNUE_HIDDEN) {
+        return false;
+    }
+
+    auto net = std::make_unique<Network>();
+    if (!read_array(in, &net->featureWeights[0][0], NNUE_INPUTS * NNUE_HIDDEN) ||
+        !read_array(in, net->featureBias, NNUE_HIDDEN) ||
+        !read_array(in, &net->outputWeights[0][0], 2 * NNUE_HIDDEN) ||
+        !read_array(in, &net->outputBias, 1)) {
+        return false;
+    }
+
+    g_net = std::move(net);
+    g_enabled.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void nnue_disable() {
+    g_enabled.store(false, std::memory_order_relaxed);
+}
+
+bool nnue_enabled() {
+    return g_enabled.load(std::memory_order_relaxed);
+}
+
+void nnue_refresh(Board& board) {
+    board.accumulators.clear();
+    if (!nnue_enabled()) return;
+    board.accumulators.reserve(MAX_PLY + 16);
+    board.accumulators.emplace_back();
+    compute_accumulator(board, board.accumulators.back());
+}
+
+void nnue_push(Board& board, const NNUEDelta& delta) {
+    board.accumulators.emplace_back();
+    NNUEAccumulator& dst = board.accumulators.back();
+    const NNUEAccumulator& src = board.accumulators[board.accumulators.size() - 2];
+
+    // Every move adds and removes at least one piece: fuse that pair with the copy.
+    for (int persp = WHITE; persp <= BLACK; persp++) {
+        add_sub_column(dst.values[persp], src.values[persp],
+                       g_net->featureWeights[feature_index(persp, delta.addPiece[0], delta.addSq[0])],
+                       g_net->featureWeights[feature_index(persp, delta.subPiece[0], delta.subSq[0])]);
+        for (int i = 1; i < delta.addCount; i++) {
+            add_column(dst.values[persp], g_net->featureWeights[feature_index(persp, delta.addPiece[i], delta.addSq[i])]);
+        }
+        for (int i = 1; i < delta.subCount; i++) {
+            sub_column(dst.values[persp], g_net->featureWeights[feature_index(persp, delta.subPiece[i], delta.subSq[i])]);
+        }
+    }
+}
+
+int nnue_evaluate(const Board& board) {
+    const NNUEAccumulator& acc = board.accumulators.back();
+#ifndef NDEBUG
+    NNUEAccumulator fresh;
+    compute_accumulator(board, fresh);
+    assert(std::memcmp(&fresh, &acc, sizeof(acc)) == 0);
+#endif
+    const int us = side_to_move(board);
+    int32_t sum = crelu_dot(acc.values[us], g_net->outputWeights[0]) +
+                  crelu_dot(acc.values[us ^ 1], g_net->outputWeights[1]) +
+                  g_net->outputBias;
+    return static_cast<int>(static_cast<int64_t>(sum) * NNUE_SCALE / (NNUE_QA * NNUE_QB));
+}
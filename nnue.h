@@ -0,0 +1,55 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <cstdint>
+#include <string>
+
+class Board;
+
+// Optional NNUE evaluation: (768 -> NNUE_HIDDEN) x 2 perspectives -> 1, CReLU.
+// Inputs are one feature per (piece colour relative to the perspective, piece type, square),
+// with squares flipped vertically for black. Weights are int16, quantised with
+// NNUE_QA (accumulator) and NNUE_QB (output layer).
+inline constexpr int NNUE_INPUTS = 768;
+inline constexpr int NNUE_HIDDEN = 256;
+inline constexpr int NNUE_QA = 255;
+inline constexpr int NNUE_QB = 64;
+inline constexpr int NNUE_SCALE = 400; // Output unit to centipawns
+
+inline constexpr char NNUE_MAGIC[8] = {'S', 'O', 'L', 'O', 'N', 'N', 'U', 'E'};
+inline constexpr uint32_t NNUE_VERSION = 1;
+
+// First layer output for both perspectives, indexed [WHITE/BLACK][neuron].
+struct alignas(64) NNUEAccumulator {
+    int16_t values[2][NNUE_HIDDEN];
+};
+
+// Pieces a move adds and removes, so makeMove can update the accumulator in one pass.
+struct NNUEDelta {
+    int addCount = 0, subCount = 0;
+    int addPiece[2], addSq[2];
+    int subPiece[2], subSq[2];
+
+    void add(int piece, int sq) { addPiece[addCount] = piece; addSq[addCount++] = sq; }
+    void sub(int piece, int sq) { subPiece[subCount] = piece; subSq[subCount++] = sq; }
+};
+
+// Network file: "SOLONNUE" magic, uint32 version, uint32 hidden size, then little-endian
+// int16 feature weights [768][hidden], int16 feature biases [hidden],
+// int16 output weights [2][hidden] (side to move first), int32 output bias.
+bool nnue_load(const std::string& path); // Enables NNUE on success, keeps the old state on failure
+void nnue_disable();
+bool nnue_enabled();
+
+// Input index of `piece` on `sq` seen from `perspective` (shared with the trainer).
+int nnue_feature_index(int perspective, int piece, int sq);
+
+// Rebuild board.accumulators as a single entry for the current position
+// (or empty it when NNUE is disabled). Call on any board a search starts from.
+void nnue_refresh(Board& board);
+// Push the child accumulator: the current top with `delta` applied.
+void nnue_push(Board& board, const NNUEDelta& delta);
+// Side-to-move score in centipawns from board.accumulators.back().
+int nnue_evaluate(const Board& board);
+
+#endif
@@ -0,0 +1,107 @@
+#include "pawns.h"
+#include "evaluation.h"
+#include "bitboard.h"
+
+namespace {
+
+constexpr Bitboard FILE_A_BB = 0x0101010101010101ULL;
+
+// Bonus by relative rank (0 = own back rank)
+constexpr int PassedRank[8] = {
+    make_score(0, 0), make_score(5, 10), make_score(10, 15), make_score(15, 25),
+    make_score(30, 45), make_score(50, 75), make_score(80, 120), make_score(0, 0),
+};
+constexpr int Isolated = make_score(-10, -12);
+constexpr int Doubled = make_score(-10, -20);
+constexpr int Backward = make_score(-8, -10);
+constexpr int Supported = make_score(8, 6);
+
+struct PawnMasks {
+    Bitboard file[8];
+    Bitboard adjacentFiles[8];
+    Bitboard forwardFile[2][64];   // Same file, strictly in front
+    Bitboard passedSpan[2][64];    // Own and adjacent files, strictly in front
+    Bitboard supportSpan[2][64];   // Adjacent files, same rank or behind
+
+    PawnMasks() {
+        for (int f = 0; f < 8; f++) file[f] = FILE_A_BB << f;
+        for (int f = 0; f < 8; f++) {
+            adjacentFiles[f] = (f > 0 ? file[f - 1] : 0) | (f < 7 ? file[f + 1] : 0);
+        }
+        for (int sq = 0; sq < 64; sq++) {
+            const int r = sq >> 3, f = sq & 7;
+            Bitboard aboveW = 0, belowB = 0; // Ranks > r, ranks < r
+            for (int rr = 0; rr < 8; rr++) {
+                Bitboard rank = 0xFFULL << (8 * rr);
+                if (rr > r) aboveW |= rank;
+                if (rr < r) belowB |= rank;
+            }
+            const Bitboard rankBB = 0xFFULL << (8 * r);
+            forwardFile[WHITE][sq] = file[f] & aboveW;
+            forwardFile[BLACK][sq] = file[f] & belowB;
+            passedSpan[WHITE][sq] = (file[f] | adjacentFiles[f]) & aboveW;
+            passedSpan[BLACK][sq] = (file[f] | adjacentFiles[f]) & belowB;
+            supportSpan[WHITE][sq] = adjacentFiles[f] & (belowB | rankBB);
+            supportSpan[BLACK][sq] = adjacentFiles[f] & (aboveW | rankBB);
+        }
+    }
+};
+
+const PawnMasks masks;
+
+// Structure score for colour `c` (positive is good for c); fills entry.passed[c].
+int evaluate_pawns(const Board& board, int c, PawnEntry& entry) {
+    const Bitboard ours = board.piece[PAWN - 1] & board.color[c];
+    const Bitboard theirs = board.piece[PAWN - 1] & board.color[c ^ 1];
+    const int forward = c == WHITE ? 8 : -8;
+    int score = 0;
+
+    Bitboard bb = ours;
+    while (bb) {
+        const int sq = lsb(bb);
+        bb &= bb - 1;
+        const int f = sq & 7;
+        const int relRank = c == WHITE ? sq >> 3 : 7 - (sq >> 3);
+
+        const bool doubled = (ours & masks.forwardFile[c][sq]) != 0;
+        const bool isolated = (ours & masks.adjacentFiles[f]) == 0;
+        const bool supported = (pawn_attacks[c ^ 1][sq] & ours) != 0;
+
+        if (doubled) score += Doubled;
+        if (isolated) score += Isolated;
+        if (supported) score += Supported;
+
+        // No friendly pawn can come alongside, and the stop square is covered by an enemy pawn
+        if (!isolated && !(ours & masks.supportSpan[c][sq]) &&
+            (pawn_attacks[c][sq + forward] & theirs)) {
+            score += Backward;
+        }
+
+        if (!doubled && !(theirs & masks.passedSpan[c][sq])) {
+            entry.passed[c] |= 1ULL << sq;
+            score += PassedRank[relRank];
+        }
+    }
+    return score;
+}
+
+} // namespace
+
+PawnTable::PawnTable() : entries(SIZE) {
+    clear();
+}
+
+void PawnTable::clear() {
+    // Key 0 with an empty entry is exactly the pawnless position, so cleared slots stay valid
+    for (PawnEntry& e : entries) e = PawnEntry{};
+}
+
+const PawnEntry& probe_pawns(const Board& board, PawnTable& table) {
+    PawnEntry& entry = table.entries[board.pawnKey & (PawnTable::SIZE - 1)];
+    if (entry.key == board.pawnKey) return entry;
+
+    entry.key = board.pawnKey;
+    entry.passed[WHITE] = entry.passed[BLACK] = 0;
+    entry.score = evaluate_pawns(board, WHITE, entry) - evaluate_pawns(board, BLACK, entry);
+    return entry;
+}
@@ -0,0 +1,28 @@
+#ifndef PAWNS_H
+#define PAWNS_H
+
+#include "board.h"
+#include <vector>
+
+// Pawn-structure terms depend only on where the pawns are, so they are cached
+// under Board::pawnKey and recomputed only on a miss.
+struct PawnEntry {
+    uint64_t key;
+    int score;              // Packed mg/eg (see make_score), white minus black
+    Bitboard passed[2];     // Passed pawns by colour
+};
+
+// Owned by a single search thread, like SearchHistory. Direct-mapped, always replace.
+struct PawnTable {
+    static constexpr size_t SIZE = 1 << 14; // Power of two
+
+    std::vector<PawnEntry> entries;
+
+    PawnTable();
+    void clear();
+};
+
+// Pawn structure of the current position from `table`, evaluated on a miss.
+const PawnEntry& probe_pawns(const Board& board, PawnTable& table);
+
+#endif
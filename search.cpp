@@ -3,19 +3,22 @@
 #include "search.h"
 #include "bitboard.h"
 #include "history.h"
+#include "movepicker.h"
+#include "attacks.h"
 #include <vector>
 #include <algorithm>
+#include <cassert>
 #include <chrono>
 #include <limits>
 #include <iostream>
 #include <atomic>
 #include <cstring>
 #include <cmath>
+#include <memory>
+#include <thread>
 
 const int PIECE_VALUES[7] = {0, 100, 320, 330, 500, 900, 20000};
 
-std::atomic<long long> nodeCount{0};
-
 int LMR_TABLE[256][256];
 float LMR_BASE = 0.77f;
 float LMR_DIVISION = 2.32f;
@@ -32,12 +35,39 @@ void initLMRtables(){
     }
 }
 
+namespace {
+// Thread 0 is the main thread; the rest are Lazy SMP helpers.
+std::vector<std::unique_ptr<SearchThread>> g_threads = [] {
+    std::vector<std::unique_ptr<SearchThread>> threads;
+    threads.push_back(std::make_unique<SearchThread>());
+    return threads;
+}();
+}
+
+void set_thread_count(int count) {
+    count = std::clamp(count, 1, MAX_THREADS);
+    while (static_cast<int>(g_threads.size()) > count) g_threads.pop_back();
+    while (static_cast<int>(g_threads.size()) < count) {
+        auto td = std::make_unique<SearchThread>();
+        td->id = static_cast<int>(g_threads.size());
+        clear_history(td->history);
+        clear_killer_moves(td->history);
+        g_threads.push_back(std::move(td));
+    }
+}
+
+int get_thread_count() {
+    return static_cast<int>(g_threads.size());
+}
+
 void resetNodeCounter() {
-    nodeCount.store(0, std::memory_order_relaxed);
+    for (auto& td : g_threads) td->nodes.store(0, std::memory_order_relaxed);
 }
 
 long long getNodeCounter() {
-    return nodeCount.load(std::memory_order_relaxed);
+    long long total = 0;
+    for (const auto& td : g_threads) total += td->nodes.load(std::memory_order_relaxed);
+    return total;
 }
 
 std::atomic<bool> stop_search(false);
@@ -45,6 +75,8 @@ std::atomic<long long> time_limit_ms{0};          // Time limit (atomic for thre
 std::atomic<long long> start_time_ms{0};          // Start time in milliseconds since epoch (atomic for thread-safety)
 std::atomic<bool> is_time_limited{false};         // Do we have time limit? (atomic for thread-safety)
 std::atomic<bool> use_tt(true);
+std::atomic<bool> search_output(true);            // Print "info" lines
+std::atomic<int> last_score{0};                   // Score of the last getBestMove result
 
 namespace {
 SearchParams g_search_params{};
@@ -66,47 +98,90 @@ void set_use_tt(bool enabled) {
     use_tt.store(enabled, std::memory_order_relaxed);
 }
 
+void set_search_output(bool enabled) {
+    search_output.store(enabled, std::memory_order_relaxed);
+}
+
+int last_search_score() {
+    return last_score.load(std::memory_order_relaxed);
+}
+
 void clear_search_heuristics() {
-    clear_history();
+    for (auto& td : g_threads) {
+        clear_history(td->history);
 
-    clear_killer_moves();
+        clear_killer_moves(td->history);
+    }
 }
 
-static bool is_square_attacked_otf(const Board& board, int row, int col, bool byWhite) {
-    int sq = row_col_to_sq(row, col);
-    const int us = byWhite ? WHITE : BLACK;
-    Bitboard occ = board.color[WHITE] | board.color[BLACK];
+void clear_eval_caches() {
+    for (auto& td : g_threads) td->evalCache.clear();
+}
 
-    Bitboard pawns = board.piece[PAWN - 1] & board.color[us];
-    Bitboard knights = board.piece[KNIGHT - 1] & board.color[us];
-    Bitboard bishops = board.piece[BISHOP - 1] & board.color[us];
-    Bitboard rooks = board.piece[ROOK - 1] & board.color[us];
-    Bitboard queens = board.piece[QUEEN - 1] & board.color[us];
-    Bitboard kings = board.piece[KING - 1] & board.color[us];
+// Side-to-move static eval of td.board, through the thread's eval cache. The NNUE output
+// layer is cheaper than a likely cache miss, so only the classic eval is cached.
+// `maps` are the node's attack maps when already computed.
+static int static_eval(SearchThread& td, const AttackMaps* maps = nullptr) {
+    if (!td.board.accumulators.empty()) return evaluate_board(td.board, td.evalTables, maps);
+    int eval;
+    if (td.evalCache.probe(td.board.currentHash, eval)) {
+        assert(eval == std::clamp(evaluate_board(td.board, td.evalTables), -32767, 32767));
+        return eval;
+    }
+    eval = evaluate_board(td.board, td.evalTables, maps);
+    td.evalCache.store(td.board.currentHash, eval);
+    return eval;
+}
 
-    if (byWhite) {
-        if (pawn_attacks[BLACK][sq] & pawns) return true;
-    } else {
-        if (pawn_attacks[WHITE][sq] & pawns) return true;
-    }
+// As above, but may return a lazy (window-only) score, which is not cached; `exact` tells.
+static int static_eval(SearchThread& td, int alpha, int beta, bool& exact) {
+    exact = true;
+    if (!td.board.accumulators.empty()) return evaluate_board(td.board, td.evalTables);
+    int eval;
+    if (td.evalCache.probe(td.board.currentHash, eval)) return eval;
+    eval = evaluate_board(td.board, td.evalTables, alpha, beta, exact);
+    if (exact) td.evalCache.store(td.board.currentHash, eval);
+    return eval;
+}
 
-    if (knight_attacks[sq] & knights) return true;
-    if (king_attacks[sq] & kings) return true;
+static int static_eval(SearchThread& td, int alpha, int beta) {
+    bool exact;
+    return static_eval(td, alpha, beta, exact);
+}
 
-    if (bishop_attacks_on_the_fly(sq, occ) & (bishops | queens)) return true;
-    if (rook_attacks_on_the_fly(sq, occ) & (rooks | queens)) return true;
+// The search scores mates by distance from the root, the TT by distance from the stored
+// node, so that a mate found at one ply is still right when the entry is hit at another.
+static int score_to_tt(int score, int ply) {
+    if (score >= MATE_SCORE - 1000) return score + ply;
+    if (score <= -MATE_SCORE + 1000) return score - ply;
+    return score;
+}
 
-    return false;
+static int score_from_tt(int score, int ply) {
+    if (score >= MATE_SCORE - 1000) return score - ply;
+    if (score <= -MATE_SCORE + 1000) return score + ply;
+    return score;
 }
 
+void get_eval_stats(uint64_t& lazyCalls, uint64_t& lazyExits) {
+    lazyCalls = lazyExits = 0;
+    for (const auto& td : g_threads) {
+        lazyCalls += td->evalTables.stats.lazyCalls;
+        lazyExits += td->evalTables.stats.lazyExits;
+    }
+}
+
+void reset_eval_stats() {
+    for (auto& td : g_threads) td->evalTables.stats = EvalStats{};
+}
 
 // Is the time limit reached?
-bool should_stop() {
+bool should_stop(const SearchThread& td) {
     if (stop_search.load(std::memory_order_relaxed)) return true;
     
     if (is_time_limited.load(std::memory_order_relaxed)) {
-        // Checking the system clock every time is expensive, so we filter with nodeCount
-        if ((nodeCount.load(std::memory_order_relaxed) & 2047) == 0) { // Check every 2048 nodes
+        // Checking the system clock every time is expensive, so we filter with the thread's node count
+        if ((td.nodes.load(std::memory_order_relaxed) & 2047) == 0) { // Check every 2048 nodes
             auto now = std::chrono::steady_clock::now();
             long long now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
             long long elapsed = now_ms - start_time_ms.load(std::memory_order_relaxed);
@@ -119,32 +194,14 @@ bool should_stop() {
     return false;
 }
 
-static std::string move_to_uci(const Move& m) {
-    std::string s;
-    s += columns[m.fromCol];
-    s += static_cast<char>('0' + (8 - m.fromRow));
-    s += columns[m.toCol];
-    s += static_cast<char>('0' + (8 - m.toRow));
-    if (m.promotion != 0) {
-        switch (m.promotion) {
-            case QUEEN: s += 'q'; break;
-            case ROOK: s += 'r'; break;
-            case BISHOP: s += 'b'; break;
-            case KNIGHT: s += 'n'; break;
-            default: break;
-        }
-    }
-    return s;
-}
-
 const int SEE_MOVE_ORDERING_THRESHOLD = -82; // ~minus pawn
 
-int scoreMove(const Board& board, const Move& move, int ply, const Move* ttMove) {
+int scoreMove(const Board& board, const SearchHistory& history, const Move& move, int ply, const Move* ttMove) {
     int moveScore = 0;
     int from = move.from_sq();
     int to = move.to_sq();
-    if (is_capture(move)) {
-        int victimPiece = move.isEnPassant ? PAWN : piece_type(move.capturedPiece);
+    if (is_capture(board, move)) {
+        int victimPiece = piece_type(captured_piece(board, move));
         int victimValue = PIECE_VALUES[victimPiece];
 
         int attackerPiece = piece_at_sq(board, from);
@@ -169,16 +226,16 @@ int scoreMove(const Board& board, const Move& move, int ply, const Move* ttMove)
     }
 
     if (ply >= 0 && ply < MAX_PLY) { 
-        if (moves_equal(move, get_killer_move(0, ply))) {
+        if (moves_equal(move, get_killer_move(history, 0, ply))) {
             moveScore += SCORE_KILLER_1;
         }
-        else if (moves_equal(move, get_killer_move(1, ply))) {
+        else if (moves_equal(move, get_killer_move(history, 1, ply))) {
             moveScore += SCORE_KILLER_2;
         }
     }
 
-    if (move.promotion != 0) {
-        switch (move.promotion){
+    if (move.promotion() != 0) {
+        switch (move.promotion()){
             case QUEEN: moveScore += SCORE_PROMO_QUEEN; break;
             case ROOK: moveScore += SCORE_PROMO_ROOK; break;
             case BISHOP: moveScore += SCORE_PROMO_BISHOP; break;
@@ -187,27 +244,28 @@ int scoreMove(const Board& board, const Move& move, int ply, const Move* ttMove)
         }
     }
 
-    if (move.isCastling) {
+    if (move.is_castling()) {
         // Castling is good for KING safety, but keep the bonus modest so we don't prefer it over
         // urgent defensive moves (like saving a hanging piece) at shallow depth
         moveScore += 500;
     }
 
-    if (get_history_score(from, to) != 0) {
-        moveScore += get_history_score(from, to);
+    if (get_history_score(history, from, to) != 0) {
+        moveScore += get_history_score(history, from, to);
     }
 
     return moveScore;
 }
 
-int quiescence(Board& board, int alpha, int beta, int ply){
-    nodeCount.fetch_add(1, std::memory_order_relaxed);
-    if (should_stop()) {
+int quiescence(SearchThread& td, int alpha, int beta, int ply, int depth){
+    Board& board = td.board;
+    td.nodes.fetch_add(1, std::memory_order_relaxed);
+    if (should_stop(td)) {
         return 0; // Search was stopped
     }
 
     if (ply >= 99) {
-        return evaluate_board(board); // Prevent infinite quiescence depth and overflows
+        return static_eval(td, alpha, beta); // Prevent infinite quiescence depth and overflows
     }
     
     // Draw detection in quiescence
@@ -218,127 +276,204 @@ int quiescence(Board& board, int alpha, int beta, int ply){
         return 0;
     }
 
-    // Do not stop until you reach a quiet position
-    int stand_pat = evaluate_board(board);
+    const SearchParams& params = get_search_params();
+    const int alphaOrig = alpha;
 
-    // Alpha-Beta pruning
-    if (stand_pat >= beta) {
-        return beta;
-    }
-    if (alpha < stand_pat) {
-        alpha = stand_pat;
-    }
+    // In check there is no stand-pat: every evasion is searched, and having none is mate
+    const bool inCheck = is_in_check(board);
+    const bool quietChecks = !inCheck && depth >= 0 && params.use_qsearch_checks;
+    const int ttDepth = (inCheck || quietChecks) ? DEPTH_QS_CHECKS : DEPTH_QS_NO_CHECKS;
 
-    std::vector<Move> captureMoves = get_capture_moves(board);
+    const uint64_t currentHash = board.currentHash;
+    int ttScore = 0;
+    int ttEntryDepth = 0;
+    TTFlag ttFlag = TTFlag::EXACT;
+    Move ttMove;
+    bool ttHit = false;
+    int staticEval = VALUE_NONE;
+    if (use_tt.load(std::memory_order_relaxed)) {
+        ttHit = globalTT.probe(currentHash, ttScore, ttEntryDepth, ttFlag, ttMove, staticEval);
+        if (ttHit) ttScore = score_from_tt(ttScore, ply);
+    }
 
-    std::sort(captureMoves.begin(), captureMoves.end(), [&](const Move& a, const Move& b) {
-        return scoreMove(board, a, ply, nullptr) > scoreMove(board, b, ply, nullptr);
-    });
+    if (ttHit && ttEntryDepth >= ttDepth) {
+        if (ttFlag == EXACT) {
+            return ttScore;
+        }
+        if (ttFlag == ALPHA && ttScore <= alpha) {
+            return alpha;
+        }
+        if (ttFlag == BETA && ttScore >= beta) {
+            return beta;
+        }
+    }
 
-    const SearchParams& params = get_search_params();
-    for (Move& move : captureMoves) {
-        if (params.use_qsearch_see) {
-            // Use threshold-based SEE with threshold 0 (must not lose material)
-            if (!staticExchangeEvaluation(board, move, 0)) {
-                continue; // Bad capture, skip it
-            }
+    int stand_pat = VALUE_NONE;
+    if (!inCheck) {
+        // Only the side of the window matters for stand-pat, so a lazy score is enough;
+        // only an exact one may go to the TT
+        if (staticEval == VALUE_NONE) {
+            bool exact;
+            stand_pat = static_eval(td, alpha, beta, exact);
+            if (exact) staticEval = stand_pat;
+        } else {
+            stand_pat = staticEval;
         }
 
-        // Delta Pruning
-        // If even the most optimistic evaluation (stand_pat + value of captured piece + margin) is worse than alpha, skip 
-        int capturedValue = PIECE_VALUES[piece_type(move.capturedPiece)];
-        if (stand_pat + capturedValue + 200 < alpha) {
-            continue; 
+        // A TT bound on the side that matters is a better guess than the static eval
+        if (ttHit && (ttFlag == EXACT || (ttFlag == BETA ? ttScore > stand_pat : ttScore < stand_pat))) {
+            stand_pat = ttScore;
         }
 
-        board.makeMove(move);
-        int kingRow = 0;
-        int kingCol = 0;
-        bool checkBlackKing = board.isWhiteTurn;
-        if (!king_square(board, !checkBlackKing, kingRow, kingCol)) {
-            board.unmakeMove(move);
-            continue;
+        // Alpha-Beta pruning
+        if (stand_pat >= beta) {
+            return beta;
         }
-        
-        if (is_square_attacked(board, kingRow, kingCol, board.isWhiteTurn)) {
-            board.unmakeMove(move);
-            continue; // illegal move
+        if (alpha < stand_pat) {
+            alpha = stand_pat;
+        }
+    } else {
+        staticEval = VALUE_NONE;
+    }
+
+    AttackInfo info;
+    compute_attack_info(board, info);
+    const Move* ttMovePtr = (ttHit && !ttMove.is_none()) ? &ttMove : nullptr;
+    MovePicker picker = inCheck ? MovePicker(board, info, td.history, ttMovePtr, ply)
+                                : MovePicker(board, info, td.history, ttMovePtr, quietChecks, params.use_qsearch_see);
+
+    Move move;
+    Move bestMove;
+    int legalMoves = 0;
+    while (picker.next(move)) {
+        legalMoves++;
+        if (!inCheck && !is_quiet(board, move)) {
+            // Delta Pruning (moves losing material by SEE never leave the picker)
+            // If even the most optimistic evaluation (stand_pat + value of captured piece + margin) is worse than alpha, skip 
+            // Quiet checks capture nothing, so they are exempt: they are searched for the check, not material.
+            int capturedValue = PIECE_VALUES[piece_type(captured_piece(board, move))];
+            if (stand_pat + capturedValue + 200 < alpha) {
+                continue; 
+            }
         }
-        int eval = -quiescence(board, -beta, -alpha, ply + 1);
+
+        board.makeMove(move);
+        globalTT.prefetch(board.currentHash);
+        int eval = -quiescence(td, -beta, -alpha, ply + 1, depth - 1);
         board.unmakeMove(move);
 
         if (eval >= beta) {
+            if (use_tt.load(std::memory_order_relaxed)) {
+                globalTT.store(currentHash, score_to_tt(beta, ply), ttDepth, BETA, move, staticEval);
+            }
             return beta;
         }
         if (eval > alpha) {
             alpha = eval;
+            bestMove = move;
         }
     }
 
+    if (inCheck && legalMoves == 0) {
+        return -MATE_SCORE + ply; // Mate
+    }
+
+    if (use_tt.load(std::memory_order_relaxed)) {
+        globalTT.store(currentHash, score_to_tt(alpha, ply), ttDepth, alpha > alphaOrig ? EXACT : ALPHA, bestMove, staticEval);
+    }
     return alpha;
 }
 
+// Singular extension tuning: minimum depth, and how far below the TT score the other
+// moves must stay for the TT move to earn a second ply
+const int SINGULAR_MIN_DEPTH = 7;
+const int DOUBLE_EXTENSION_MARGIN = 25;
+const int MAX_DOUBLE_EXTENSIONS = 6;
+
+// ProbCut: margin over beta, minimum depth and depth reduction of the verification search
+const int PROBCUT_MARGIN = 200;
+const int PROBCUT_MIN_DEPTH = 5;
+const int PROBCUT_REDUCTION = 4;
+
+// TT key of a singular verification search: the position with `excluded` removed from
+// its move list must not share entries with the full position
+static uint64_t excluded_key(uint64_t hash, Move excluded) {
+    uint64_t x = excluded.data;
+    return hash ^ Zobrist::splitmix64(x);
+}
+
 // Negamax
-int negamax(Board& board, int depth, int alpha, int beta, int ply, std::vector<uint64_t>& positionHistory, std::vector<Move>& pvLine) {
+int negamax(SearchThread& td, int depth, int alpha, int beta, int ply) {
 
-    Move badQuiets[256]; // Store bad quiet moves for move ordering
-    int badQuietCount = 0;
+    Board& board = td.board;
+    std::vector<uint64_t>& positionHistory = td.positionHistory;
 
-    nodeCount.fetch_add(1, std::memory_order_relaxed);
+    td.nodes.fetch_add(1, std::memory_order_relaxed);
+    td.pvTable.clear(ply); // Every early return leaves an empty line for the parent
 
-    if (should_stop()) {
+    if (should_stop(td)) {
         return 0; // Search was stopped
     }
 
+    // No room left in the per-ply tables
+    if (ply >= MAX_PLY - 1) {
+        return static_eval(td);
+    }
+
+    SearchStack* ss = td.stack_at(ply);
+    const Move excludedMove = ss->excludedMove; // Set by the parent-ply singular search
+    ss->moveCount = 0;
+    ss->badQuietCount = 0;
+    ss->doubleExtensions = (ss - 1)->doubleExtensions;
+
     const SearchParams& params = get_search_params();
     bool pvNode = (beta - alpha) > 1;
     bool firstMove = true;
     const int alphaOrig = alpha;
     int maxEval = VALUE_NONE;
 
-    int kRow = 0;
-    int kCol = 0;
-    if (!king_square(board, board.isWhiteTurn, kRow, kCol)) {
-        pvLine.clear();
+    if (!(board.piece[KING - 1] & board.color[side_to_move(board)])) {
         return 0;
     }
-    bool inCheck = is_square_attacked(board, kRow, kCol, !board.isWhiteTurn);
+    const bool inCheck = is_in_check(board);
 
     if (inCheck) {
         depth++; // Check extension
     }
 
+    // Quiescence builds its own AttackInfo, and only when it gets past stand-pat
     if (depth <= 0) {
-        pvLine.clear();
-        return quiescence(board, alpha, beta, ply);
+        return quiescence(td, alpha, beta, ply);
     }
 
     // Draw detection: threefold repetition
     if (is_threefold_repetition(positionHistory)) {
-        pvLine.clear();
         return 0; // Draw
     }
     
     // Draw detection: 50-move rule
     if (is_fifty_move_draw(board)) {
-        pvLine.clear();
         return 0; // Draw
     }
     
     // Draw detection: insufficient material
     if (is_insufficient_material(board)) {
-        pvLine.clear();
         return 0; // Draw
     }
 
-    uint64_t currentHash = position_key(board);
+    const uint64_t currentHash = board.currentHash;
+    const uint64_t ttKey = excludedMove.is_none() ? currentHash : excluded_key(currentHash, excludedMove);
     int ttScore = 0;
     int ttDepth = 0;
     TTFlag ttFlag = TTFlag::EXACT;
     Move ttMove;
     bool ttHit = false;
+    // Static eval (side-to-move POV) is computed after the TT cutoffs, unless a TT hit
+    // already carries it.
+    int staticEval = VALUE_NONE;
     if (use_tt.load(std::memory_order_relaxed)) {
-        ttHit = globalTT.probe(currentHash, ttScore, ttDepth, ttFlag, ttMove);
+        ttHit = globalTT.probe(ttKey, ttScore, ttDepth, ttFlag, ttMove, staticEval);
+        if (ttHit) ttScore = score_from_tt(ttScore, ply);
     }
 
     int movesSearched = 0;
@@ -354,158 +489,219 @@ int negamax(Board& board, int depth, int alpha, int beta, int ply, std::vector<u
         }
     }
 
-    // Static evaluation (from side-to-move perspective). Used by forward/reverse pruning.
-    const int staticEval = evaluate_board(board);
     if (!is_repetition_candidate && ttHit && ttDepth >= depth) {
         if (ttFlag == EXACT) {
-            pvLine.clear();
             return ttScore;
         }
 
         if (!is_repetition_candidate && ttFlag == ALPHA && ttScore <= alpha) {
-            pvLine.clear();
             return alpha;
         }
         if (!is_repetition_candidate && ttFlag == BETA && ttScore >= beta) {
-            pvLine.clear();
             return beta;
         }
     }
 
+    // Checkers, pins and both sides' attack maps, shared by move generation and the eval.
+    // Built only now: draw and TT-cutoff nodes never need them.
+    AttackInfo info;
+    compute_attack_info(board, info);
+    assert(inCheck == info.in_check());
+
+    // Improving: our static eval went up since our previous move. Pruning that guards
+    // against failing high is then safer, pruning that assumes a fail low less so.
+    if (!inCheck && staticEval == VALUE_NONE) staticEval = static_eval(td, &info.maps);
+    ss->staticEval = inCheck ? VALUE_NONE : staticEval;
+    const int prevEval = (ss - 2)->staticEval != VALUE_NONE ? (ss - 2)->staticEval : (ss - 4)->staticEval;
+    const bool improving = !inCheck && (prevEval == VALUE_NONE || ss->staticEval > prevEval);
+
+    // Internal Iterative Reduction: without a TT move the ordering here is poor, and a
+    // shallower search is cheaper and will leave a move for the next iteration
+    if (depth >= 4 && excludedMove.is_none() && !(ttHit && !ttMove.is_none())) {
+        depth--;
+    }
 
     // Reverse Futility Pruning 
     // Only makes sense in non-PV nodes (null-window), otherwise it can prune good PV continuations.
-    if ((beta - alpha) == 1 && depth < 9 && !inCheck && beta < MATE_SCORE - 100) {
+    if ((beta - alpha) == 1 && depth < 9 && !inCheck && excludedMove.is_none() && beta < MATE_SCORE - 100) {
         
-        // margin: for every depth, we allow a margin of 100 centipawns
+        // margin: for every depth, we allow a margin of 80 centipawns (one depth less when improving)
         // The deeper we go, the larger the margin should be
-        int margin = 80 * depth; 
+        int margin = 80 * (depth - improving);
 
-        if (staticEval - margin >= beta) {
+        if (ss->staticEval - margin >= beta) {
             // "I'm so far ahead that even if I reduce the margin, I still surpass the opponent's threshold, so I don't need to search further and lose time"
-            pvLine.clear();
             return beta; // Cutoff
         }
     }
 
     // Null move pruning
     {
-        int kingRow = 0;
-        int kingCol = 0;
-        if (!king_square(board, board.isWhiteTurn, kingRow, kingCol)) {
-            pvLine.clear();
-            return 0;
-        }
-        // Check if side to move is currently in check
-        bool inCheck = is_square_attacked(board, kingRow, kingCol, !board.isWhiteTurn);
-
-        if (!inCheck && depth >= 3 && (beta - alpha == 1)) {
+        if (!inCheck && depth >= 3 && (beta - alpha == 1) && excludedMove.is_none()) {
             // Make a "null move" by flipping side to move
-            const int prevEnPassantCol = board.enPassantCol;
-
-            board.enPassantCol = -1; // En passant rights vanish after a null move.
-            board.isWhiteTurn = !board.isWhiteTurn;
+            ss->currentMove = Move();
+            board.makeNullMove();
+            globalTT.prefetch(board.currentHash);
 
             // Push new position key to positionHistory so threefold repetition checks remain correct
-            uint64_t nullHash = position_key(board);
-            positionHistory.push_back(nullHash);
+            positionHistory.push_back(board.currentHash);
 
             // Reduction factor R (typical values 2..3). Ensure we don't search negative depth
             int R = std::min(3, std::max(1, depth - 2));
-            std::vector<Move> nullPv;
-            int nullScore = -negamax(board, depth - 1 - R, -beta, -beta + 1, ply + 1, positionHistory, nullPv);
+            int nullScore = -negamax(td, depth - 1 - R, -beta, -beta + 1, ply + 1);
 
             // Undo positionHistory change and null move
             if (!positionHistory.empty()) positionHistory.pop_back();
-            board.isWhiteTurn = !board.isWhiteTurn;
-            board.enPassantCol = prevEnPassantCol;
+            board.unmakeNullMove();
 
             if (nullScore >= beta) {
-                pvLine.clear();
                 return beta; // Null-move cutoff
             }
         }
     }
 
-    std::vector<Move> possibleMoves = get_all_moves(board, board.isWhiteTurn);
-    Move bestMove = possibleMoves.empty() ? Move() : possibleMoves[0];
+    // ProbCut: a capture that beats beta by a margin in a reduced search will very likely
+    // beat beta at full depth. Only captures whose SEE covers the margin are tried, and a
+    // quiescence search screens each one before the reduced search.
+    const int probCutBeta = beta + PROBCUT_MARGIN;
+    if (!pvNode && !inCheck && depth >= PROBCUT_MIN_DEPTH && excludedMove.is_none() &&
+        std::abs(beta) < MATE_SCORE - 100 &&
+        !(ttHit && ttDepth >= depth - 3 && ttScore < probCutBeta)) {
+        MovePicker capturePicker(board, info, td.history, ttHit ? &ttMove : nullptr, false, false);
+        Move capture;
+        while (capturePicker.next(capture)) {
+            if (!staticExchangeEvaluation(board, capture, probCutBeta - ss->staticEval)) {
+                continue;
+            }
+
+            ss->currentMove = capture;
+            board.makeMove(capture);
+            globalTT.prefetch(board.currentHash);
+            positionHistory.push_back(board.currentHash);
 
-    if (possibleMoves.empty()) {
-        int kingRow = 0;
-        int kingCol = 0;
-        if (!king_square(board, board.isWhiteTurn, kingRow, kingCol)) {
-            return 0;
+            int score = -quiescence(td, -probCutBeta, -probCutBeta + 1, ply + 1);
+            if (score >= probCutBeta) {
+                score = -negamax(td, depth - PROBCUT_REDUCTION, -probCutBeta, -probCutBeta + 1, ply + 1);
+            }
+
+            positionHistory.pop_back();
+            board.unmakeMove(capture);
+
+            if (score >= probCutBeta) {
+                if (use_tt.load(std::memory_order_relaxed)) {
+                    globalTT.store(ttKey, score_to_tt(probCutBeta, ply), depth - PROBCUT_REDUCTION + 1, BETA, capture, staticEval);
+                }
+                return beta; // Fail-hard, like the other cutoffs
+            }
         }
-        if (is_square_attacked(board, kingRow, kingCol, !board.isWhiteTurn)) 
-            return -MATE_SCORE + ply; // Mate
-        return 0; // Stalemate
     }
 
-    // Move Ordering
-    std::sort(possibleMoves.begin(), possibleMoves.end(), [&](const Move& a, const Move& b) {
-        const Move* ttMovePtr = ttHit ? &ttMove : nullptr;
-        return scoreMove(board, a, ply, ttMovePtr) > scoreMove(board, b, ply, ttMovePtr);
-    });
-    
-    for (Move& move : possibleMoves) {
+    Move bestMove;
+    int legalMoves = 0;
+
+    // Move Ordering: staged picker (TT move, good captures, killers, quiets, bad captures)
+    MovePicker picker(board, info, td.history, ttHit ? &ttMove : nullptr, ply);
+    Move move;
+    while (picker.next(move)) {
+        if (moves_equal(move, excludedMove)) {
+            continue;
+        }
+        if (legalMoves++ == 0) {
+            bestMove = move;
+        }
+        const bool isQuiet = is_quiet(board, move);
 
         // Futility Pruning
-        if (depth < 3 && !inCheck && move.promotion == 0 && is_quiet(move)) {
-            int futilityMargin = 100 + 60 * depth; // Margin increases with depth
-            if (staticEval + futilityMargin < alpha) {
+        if (depth < 3 && !inCheck && isQuiet) {
+            int futilityMargin = 100 + 60 * depth + 40 * improving; // Margin increases with depth
+            if (ss->staticEval + futilityMargin < alpha) {
                 continue; // Skip this move, it's unlikely to raise the evaluation enough
             }
 
         }
 
-        int lmpCount = (3 * depth * depth) + 4;
+        int lmpCount = ((3 * depth * depth) + 4) / (2 - improving);
         // Late Move Pruning (LMP) logic
         if (params.use_lmp && !pvNode &&
             depth >= params.lmp_min_depth &&
             depth <= params.lmp_max_depth &&
             movesSearched >= lmpCount &&
-            !inCheck && move.promotion == 0 && move.capturedPiece == 0) {
-            if (!move.isEnPassant && !is_killer_move(move, ply)) {
+            !inCheck && isQuiet) {
+            if (!is_killer_move(td.history, move, ply)) {
                 continue; // skip this move (late move pruning)
             }
         }
 
+        // Singular extension: if every other move fails well below the TT score in a
+        // reduced search without the TT move, the TT move is forced and searched deeper
+        int extension = 0;
+        if (depth >= SINGULAR_MIN_DEPTH && excludedMove.is_none() && ttHit && moves_equal(move, ttMove) &&
+            ttFlag != ALPHA && ttDepth >= depth - 3 && std::abs(ttScore) < MATE_SCORE - 100) {
+            const int singularBeta = ttScore - 2 * depth;
+
+            // The verification search reuses this ply's stack entry; keep our move count
+            // and bad quiets out of its reach
+            const int savedMoveCount = ss->moveCount;
+            const int savedBadQuietCount = ss->badQuietCount;
+            Move savedBadQuiets[MAX_MOVES];
+            std::memcpy(savedBadQuiets, ss->badQuiets, savedBadQuietCount * sizeof(Move));
+
+            ss->excludedMove = move;
+            const int singularScore = negamax(td, (depth - 1) / 2, singularBeta - 1, singularBeta, ply);
+            ss->excludedMove = Move();
+
+            ss->moveCount = savedMoveCount;
+            ss->badQuietCount = savedBadQuietCount;
+            std::memcpy(ss->badQuiets, savedBadQuiets, savedBadQuietCount * sizeof(Move));
+
+            if (singularScore < singularBeta) {
+                extension = 1;
+                if (!pvNode && singularScore < singularBeta - DOUBLE_EXTENSION_MARGIN &&
+                    ss->doubleExtensions < MAX_DOUBLE_EXTENSIONS) {
+                    extension = 2;
+                }
+            } else if (singularBeta >= beta) {
+                // Multi-cut: the TT move and at least one other move both beat beta
+                return singularBeta;
+            }
+        }
+        const int newDepth = depth - 1 + extension;
+        ss->doubleExtensions = (ss - 1)->doubleExtensions + (extension == 2);
+
+        ss->currentMove = move;
         board.makeMove(move);
-        movesSearched++;
-        std::vector<Move> childPv;
-        uint64_t newHash = position_key(board);
-        positionHistory.push_back(newHash);
+        globalTT.prefetch(board.currentHash);
+        ss->moveCount = ++movesSearched;
+        positionHistory.push_back(board.currentHash);
         if (firstMove){
-            eval = -negamax(board, depth - 1, -beta, -alpha, ply + 1, positionHistory, childPv);
+            eval = -negamax(td, newDepth, -beta, -alpha, ply + 1);
             firstMove = false;
         }
         else {
             // Late Move Reduction (LMR)
             int reduction = 0;
-            std::vector<Move> nullWindowPv;
             if (params.use_lmr &&
-                depth > 1 && is_quiet(move)) {
+                depth > 1 && isQuiet) {
                 int lmrTableDepth = std::min(depth, 255);
                 int lmrTableMovesSearched = std::min(movesSearched, 255);
                 reduction = LMR_TABLE[lmrTableDepth][lmrTableMovesSearched]; // Increase reduction with depth
                 if (reduction < 0) reduction = 0;
-                if (reduction > depth - 1) reduction = depth - 1;
-                if (depth - 1 - reduction < 1) reduction = depth - 2; // Ensure we don't search negative depth
+                if (reduction > newDepth) reduction = newDepth;
+                if (newDepth - reduction < 1) reduction = newDepth - 1; // Ensure we don't search negative depth
             }
-            int lmrDepth = std::max(0, depth - 1 - reduction);
+            int lmrDepth = std::max(0, newDepth - reduction);
 
-            eval = -negamax(board, lmrDepth, -alpha - 1, -alpha, ply + 1, positionHistory, nullWindowPv);
+            eval = -negamax(td, lmrDepth, -alpha - 1, -alpha, ply + 1);
 
             if (reduction > 0 && eval > alpha) {
                 // Re-search at full depth if reduced search suggests a better move
-                eval = -negamax(board, depth - 1, -alpha - 1, -alpha, ply + 1, positionHistory, childPv);
+                eval = -negamax(td, newDepth, -alpha - 1, -alpha, ply + 1);
             }
 
             if (eval > alpha && eval < beta) {
-                childPv.clear();
-                eval = -negamax(board, depth - 1, -beta, -alpha, ply + 1, positionHistory, childPv);
+                eval = -negamax(td, newDepth, -beta, -alpha, ply + 1);
             } else {
-                childPv.clear();
+                td.pvTable.clear(ply + 1); // Null-window lines are not PVs
             }
         }
         if (!positionHistory.empty()) positionHistory.pop_back();
@@ -514,9 +710,7 @@ int negamax(Board& board, int depth, int alpha, int beta, int ply, std::vector<u
         if (eval > maxEval) {
             maxEval = eval;
             bestMove = move;
-            pvLine.clear();
-            pvLine.push_back(move);
-            pvLine.insert(pvLine.end(), childPv.begin(), childPv.end());
+            td.pvTable.update(ply, move);
         }
 
         if (eval > alpha) {
@@ -525,84 +719,134 @@ int negamax(Board& board, int depth, int alpha, int beta, int ply, std::vector<u
 
         if (beta <= alpha) {
             // Quiet move caused beta cutoff - update killer moves
-            if (is_quiet(move)) {
-                add_killer_move(move, ply);
+            if (isQuiet) {
+                add_killer_move(td.history, move, ply);
             }
             
             // Update history
             int from = move.from_sq();
             int to = move.to_sq();
             if (from >= 0 && from < 64 && to >= 0 && to < 64) {
-                update_history(from, to, depth, badQuiets, badQuietCount);
+                update_history(td.history, from, to, depth, ss->badQuiets, ss->badQuietCount);
             }
             
             break; // beta cutoff
         } else {
-            if (is_quiet(move)) {
-                if (badQuietCount < 256){
-                    badQuiets[badQuietCount++] = move;
+            if (isQuiet) {
+                if (ss->badQuietCount < MAX_MOVES){
+                    ss->badQuiets[ss->badQuietCount++] = move;
                 }
             }
         }
     }
 
+    if (legalMoves == 0) {
+        if (!excludedMove.is_none())
+            return alpha; // The excluded move was the only one: it is singular
+        if (inCheck) 
+            return -MATE_SCORE + ply; // Mate
+        return 0; // Stalemate
+    }
+
     TTFlag flag;
     if (maxEval <= alphaOrig) flag = ALPHA;
     else if (maxEval >= beta) flag = BETA;
     else flag = EXACT;
     
     if (use_tt.load(std::memory_order_relaxed)) {
-        globalTT.store(currentHash, maxEval, depth, flag, bestMove);
+        globalTT.store(ttKey, score_to_tt(maxEval, ply), depth, flag, bestMove, staticEval);
     }
     return maxEval;
 }
 
-Move getBestMove(Board& board, int maxDepth, int movetimeMs, const std::vector<uint64_t>& positionHistory, int ply) {
+namespace {
 
-    // Reset variables
-    resetNodeCounter();
-    stop_search.store(false, std::memory_order_relaxed);
-    const SearchParams& params = get_search_params();
-    
-    // Time settings
-    auto now = std::chrono::steady_clock::now();
-    start_time_ms.store(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count(), std::memory_order_relaxed);
-    if (movetimeMs > 0) {
-        is_time_limited.store(true, std::memory_order_relaxed);
-        long long time_limit = movetimeMs; // Do not use the entire time given by the GUI leave a small margin
-        if (time_limit > 50) time_limit -= 20; // 20ms safety margin
-        time_limit_ms.store(time_limit, std::memory_order_relaxed);
+// Depth staggering for Lazy SMP helpers: helper i skips iterations according to
+// (SkipSize, SkipPhase) so neighbouring helpers spread over different depths.
+const int SkipSize[]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+const int SkipPhase[] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+bool skip_depth(const SearchThread& td, int depth) {
+    if (td.id == 0) return false;
+    const int i = (td.id - 1) % 20;
+    return ((depth + SkipPhase[i]) / SkipSize[i]) % 2 != 0;
+}
+
+void print_info(const SearchThread& td, std::chrono::steady_clock::time_point searchStart) {
+    if (!search_output.load(std::memory_order_relaxed)) return;
+    auto searchEnd = std::chrono::steady_clock::now();
+    long long duration = std::chrono::duration_cast<std::chrono::milliseconds>(searchEnd - searchStart).count();
+    long long nodes = getNodeCounter();
+    std::cout << "info depth " << td.completedDepth << " ";
+    long long nps = 0;
+    if (duration > 0) {
+        nps = (nodes * 1000LL) / duration;
+    }
+    if (std::abs(td.bestScore) >= MATE_SCORE - 1000) {
+        int mateIn = (MATE_SCORE - std::abs(td.bestScore) + 1) / 2;
+        if (td.bestScore < 0) mateIn = -mateIn;
+        std::cout << "score mate " << mateIn;
     } else {
-        is_time_limited.store(false, std::memory_order_relaxed);
-        time_limit_ms.store(0, std::memory_order_relaxed);
+        std::cout << "score cp " << td.bestScore;
     }
+    std::cout << " nodes " << nodes
+                << " time " << duration
+                << " nps " << nps
+                << " pv ";
+    for (const Move& pvMove : td.pv) {
+        std::cout << move_to_uci(pvMove) << " ";
+    }
+    std::cout << std::endl;
+}
 
-    bool isWhite = board.isWhiteTurn;
-    std::vector<Move> possibleMoves = get_all_moves(board, isWhite);
-    std::sort(possibleMoves.begin(), possibleMoves.end(), [&](const Move& a, const Move& b) {
-        return scoreMove(board, a, 0, nullptr) > scoreMove(board, b, 0, nullptr);
-    });
-    if (possibleMoves.empty()) return {};
-    if (possibleMoves.size() == 1) return possibleMoves[0];
+// Iterative deepening with aspiration windows on one thread's private board.
+void iterative_deepening(SearchThread& td, int maxDepth, int ply, std::chrono::steady_clock::time_point searchStart) {
+    Board& board = td.board;
+    const SearchParams& params = get_search_params();
 
-    Move bestMoveSoFar = possibleMoves[0]; 
+    MoveList possibleMoves;
+    get_all_moves(board, possibleMoves);
+    if (possibleMoves.empty()) return;
+    int moveScores[MAX_MOVES];
+
+    // Score every root move once, then insertion-sort by the cached scores (stable).
+    auto order_root_moves = [&](const Move* pvMove) {
+        for (int i = 0; i < possibleMoves.size(); i++) {
+            moveScores[i] = scoreMove(board, td.history, possibleMoves[i], 0, nullptr);
+            if (pvMove != nullptr && moves_equal(possibleMoves[i], *pvMove)) moveScores[i] = std::numeric_limits<int>::max();
+        }
+        for (int i = 1; i < possibleMoves.size(); i++) {
+            Move m = possibleMoves[i];
+            int score = moveScores[i];
+            int j = i - 1;
+            while (j >= 0 && moveScores[j] < score) {
+                possibleMoves[j + 1] = possibleMoves[j];
+                moveScores[j + 1] = moveScores[j];
+                j--;
+            }
+            possibleMoves[j + 1] = m;
+            moveScores[j + 1] = score;
+        }
+    };
+    order_root_moves(nullptr);
 
-    auto gSearchStart = std::chrono::steady_clock::now();
-    auto gTimeLimited = (movetimeMs > 0);
-    auto gTimeLimitMs = gTimeLimited ? movetimeMs : std::numeric_limits<int>::max();
-    const int effectiveMaxDepth = gTimeLimited ? 128 : maxDepth;
-    int bestValue;
+    // The root and the sentinels below it have no static eval or move for children to look back at
+    for (SearchStack* ss = td.stack; ss <= td.stack_at(ply); ss++) {
+        ss->staticEval = VALUE_NONE;
+        ss->currentMove = ss->excludedMove = Move();
+        ss->moveCount = ss->badQuietCount = ss->doubleExtensions = 0;
+    }
 
-    std::vector<uint64_t> localPositionHistory;
-    localPositionHistory.reserve(std::min((size_t)100, positionHistory.size()) + 1);
-    auto startIt = (positionHistory.size() > 100) ? (positionHistory.end() - 100) : positionHistory.begin(); // Keep only last 100 entries
-    localPositionHistory.assign(startIt, positionHistory.end());
+    Move bestMoveSoFar = possibleMoves[0]; 
+    td.bestMove = bestMoveSoFar;
+    int bestValue = 0;
 
     int lastScore = 0; // for aspiration windows
 
-    for (int depth = 1; depth <= effectiveMaxDepth; depth++) {
+    for (int depth = 1; depth <= maxDepth; depth++) {
 
         if (stop_search.load(std::memory_order_relaxed)) break;
+        if (skip_depth(td, depth)) continue;
 
         int delta = params.aspiration_delta; // Aspiration window margin
         int alpha = -VALUE_INF;
@@ -623,41 +867,23 @@ Move getBestMove(Board& board, int maxDepth, int movetimeMs, const std::vector<u
             if (depth > 1) {
                 // Here we use bestMoveSoFar because it was the winner of the previous depth
                 Move pvMove = bestMoveSoFar; 
-                std::stable_sort(possibleMoves.begin(), possibleMoves.end(), [&](const Move& a, const Move& b) {
-                    const bool aIsPV = (a.fromRow == pvMove.fromRow && a.fromCol == pvMove.fromCol && a.toRow == pvMove.toRow && a.toCol == pvMove.toCol && a.promotion == pvMove.promotion);
-                    const bool bIsPV = (b.fromRow == pvMove.fromRow && b.fromCol == pvMove.fromCol && b.toRow == pvMove.toRow && b.toCol == pvMove.toCol && b.promotion == pvMove.promotion);
-
-                    // Strict-weak-ordering: comparator must be irreflexive (never a < a).
-                    if (aIsPV != bIsPV) return aIsPV;
-
-                    const int sa = scoreMove(board, a, 0, nullptr);
-                    const int sb = scoreMove(board, b, 0, nullptr);
-                    if (sa != sb) return sa > sb;
-
-                    // Deterministic tie-breaker.
-                    if (a.fromRow != b.fromRow) return a.fromRow < b.fromRow;
-                    if (a.fromCol != b.fromCol) return a.fromCol < b.fromCol;
-                    if (a.toRow != b.toRow) return a.toRow < b.toRow;
-                    if (a.toCol != b.toCol) return a.toCol < b.toCol;
-                    return a.promotion < b.promotion;
-                });
+                order_root_moves(&pvMove);
             }
 
-            std::vector<Move> bestPvForDepth;
+            td.pvTable.clear(ply);
             for (Move move : possibleMoves) {
                 if (stop_search.load(std::memory_order_relaxed)) {
                     thisDepthCompleted = false;
                     break; 
                 }
 
+                td.stack_at(ply)->currentMove = move;
                 board.makeMove(move);
+                globalTT.prefetch(board.currentHash);
 
-                std::vector<Move> childPv;
-
-                uint64_t newHash = position_key(board);
-                localPositionHistory.push_back(newHash);
-                int val = -negamax(board, depth - 1, -beta, -alpha, ply + 1, localPositionHistory, childPv);
-                localPositionHistory.pop_back();
+                td.positionHistory.push_back(board.currentHash);
+                int val = -negamax(td, depth - 1, -beta, -alpha, ply + 1);
+                td.positionHistory.pop_back();
                 
                 board.unmakeMove(move);
 
@@ -669,9 +895,7 @@ Move getBestMove(Board& board, int maxDepth, int movetimeMs, const std::vector<u
                 if (val > bestValue) {
                     bestValue = val;
                     currentDepthBestMove = move;
-                    bestPvForDepth.clear();
-                    bestPvForDepth.push_back(move);
-                    bestPvForDepth.insert(bestPvForDepth.end(), childPv.begin(), childPv.end());
+                    td.pvTable.update(ply, move);
                     
                     if (bestValue > alpha) {
                         alpha = bestValue;
@@ -700,27 +924,13 @@ Move getBestMove(Board& board, int maxDepth, int movetimeMs, const std::vector<u
             if (thisDepthCompleted && (bestValue > std::numeric_limits<int>::min() / 2)) {
                 bestMoveSoFar = currentDepthBestMove;
                 lastScore = bestValue;
-                auto searchEnd = std::chrono::steady_clock::now();
-                long long duration = std::chrono::duration_cast<std::chrono::milliseconds>(searchEnd - gSearchStart).count();
-                std::cout << "info depth " << depth << " ";
-                long long nps = 0;
-                if (duration > 0) {
-                    nps = (getNodeCounter() * 1000LL) / duration;
+                td.bestMove = bestMoveSoFar;
+                td.bestScore = bestValue;
+                td.completedDepth = depth;
+                td.pv.assign(td.pvTable.line[ply], td.pvTable.line[ply] + td.pvTable.length[ply]);
+                if (td.id == 0) {
+                    print_info(td, searchStart);
                 }
-                if (std::abs(bestValue) >= MATE_SCORE - 1000) {
-                    int mateIn = (MATE_SCORE - std::abs(bestValue) + 1) / 2;
-                    if (bestValue < 0) mateIn = -mateIn;
-                    std::cout << "score mate " << mateIn;
-                } else {
-                    std::cout << "score cp " << bestValue;
-                }
-                std::cout << " time " << duration
-                            << " nps " << nps
-                            << " pv ";
-                for (const Move& pvMove : bestPvForDepth) {
-                    std::cout << move_to_uci(pvMove) << " ";
-                }
-                std::cout << std::endl;
             }
             break; // Exit aspiration window loop
         }
@@ -729,6 +939,83 @@ Move getBestMove(Board& board, int maxDepth, int movetimeMs, const std::vector<u
             break;
         }
     }
+}
+
+} // namespace
+
+Move getBestMove(Board& board, int maxDepth, int movetimeMs, const std::vector<uint64_t>& positionHistory, int ply) {
+
+    // Reset variables
+    resetNodeCounter();
+    stop_search.store(false, std::memory_order_relaxed);
+    globalTT.new_search();
+    
+    // Time settings
+    auto now = std::chrono::steady_clock::now();
+    start_time_ms.store(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count(), std::memory_order_relaxed);
+    if (movetimeMs > 0) {
+        is_time_limited.store(true, std::memory_order_relaxed);
+        long long time_limit = movetimeMs; // Do not use the entire time given by the GUI leave a small margin
+        if (time_limit > 50) time_limit -= 20; // 20ms safety margin
+        time_limit_ms.store(time_limit, std::memory_order_relaxed);
+    } else {
+        is_time_limited.store(false, std::memory_order_relaxed);
+        time_limit_ms.store(0, std::memory_order_relaxed);
+    }
+
+    last_score.store(0, std::memory_order_relaxed);
+    MoveList rootMoves;
+    get_all_moves(board, rootMoves);
+    if (rootMoves.empty()) return {};
+    if (rootMoves.size() == 1) return rootMoves[0];
+
+    auto gSearchStart = std::chrono::steady_clock::now();
+    auto gTimeLimited = (movetimeMs > 0);
+    const int effectiveMaxDepth = gTimeLimited ? 128 : maxDepth;
+
+    // Start every thread from a freshly computed NNUE accumulator (no-op when NNUE is off)
+    nnue_refresh(board);
+
+    auto startIt = (positionHistory.size() > 100) ? (positionHistory.end() - 100) : positionHistory.begin(); // Keep only last 100 entries
+    for (auto& td : g_threads) {
+        td->board = board;
+        td->positionHistory.reserve(std::min((size_t)100, positionHistory.size()) + MAX_PLY + 1);
+        td->positionHistory.assign(startIt, positionHistory.end());
+        td->bestMove = rootMoves[0];
+        td->bestScore = 0;
+        td->completedDepth = 0;
+        td->pv.clear();
+    }
+
+    // Lazy SMP: helpers search the same root on their own boards, sharing only globalTT.
+    std::vector<std::thread> helpers;
+    helpers.reserve(g_threads.size() - 1);
+    for (size_t i = 1; i < g_threads.size(); i++) {
+        SearchThread* td = g_threads[i].get();
+        helpers.emplace_back([td, effectiveMaxDepth, ply, gSearchStart]() {
+            iterative_deepening(*td, effectiveMaxDepth, ply, gSearchStart);
+        });
+    }
+
+    SearchThread& mainThread = *g_threads[0];
+    iterative_deepening(mainThread, effectiveMaxDepth, ply, gSearchStart);
+
+    // The main thread decides when the search is over.
+    stop_search.store(true, std::memory_order_relaxed);
+    for (std::thread& helper : helpers) helper.join();
+
+    // Prefer a helper that finished a deeper iteration without a worse score.
+    SearchThread* best = &mainThread;
+    for (size_t i = 1; i < g_threads.size(); i++) {
+        SearchThread* td = g_threads[i].get();
+        if (td->completedDepth > best->completedDepth && td->bestScore >= best->bestScore) {
+            best = td;
+        }
+    }
+    if (best != &mainThread) {
+        print_info(*best, gSearchStart);
+    }
+    last_score.store(best->bestScore, std::memory_order_relaxed);
 
-    return bestMoveSoFar; // Return the best move found within time/depth limits 
+    return best->bestMove; // Return the best move found within time/depth limits 
 }
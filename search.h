@@ -2,15 +2,14 @@
 #define SEARCH_H
 
 #include "board.h"
+#include "history.h"
+#include "evaluation.h"
 #include <vector>
 #include <cstdint>
 #include <atomic>
 #include <cstring>
 
 extern char columns[];
-extern Move killerMove[2][MAX_PLY]; // 2 slots
-extern int historyTable[64][64];    // fromSquare x toSquare
-extern std::atomic<long long> nodeCount; // visited node counter
 extern int LMR_TABLE[256][256];     // Late Move Reduction table
 
 extern void initLMRtables();
@@ -21,6 +20,7 @@ struct SearchParams {
 	bool use_lmp = true;          // Late Move Pruning
 	bool use_aspiration = true;   // Aspiration windows in iterative deepening
 	bool use_qsearch_see = true; // SEE-based pruning inside quiescence
+	bool use_qsearch_checks = false; // Quiet checks at the first quiescence ply (off: slower, no gain measured)
 
 	int lmp_min_depth = 4;        // Minimum depth to consider LMP
 	int lmp_max_depth = 8;        // Maximum depth to consider LMP
@@ -28,18 +28,75 @@ struct SearchParams {
 	int aspiration_delta = 50;    // Initial aspiration half-window in centipawns
 };
 
+inline constexpr int MAX_THREADS = 256;
+
+// Triangular PV table: line[ply] holds the best line found from ply (its first length[ply]
+// moves). A node that improves copies its child's line in behind its own move.
+struct PVTable {
+	Move line[MAX_PLY + 1][MAX_PLY + 1];
+	int length[MAX_PLY + 1];
+
+	void clear(int ply) { length[ply] = 0; }
+	void update(int ply, const Move& move) {
+		line[ply][0] = move;
+		std::memcpy(&line[ply][1], line[ply + 1], length[ply + 1] * sizeof(Move));
+		length[ply] = length[ply + 1] + 1;
+	}
+};
+
+// Per-ply search state. A node owns stack_at(ply) and may look back at its ancestors'
+// entries, so iterative deepening resets the sentinels below the root.
+struct SearchStack {
+	int staticEval;               // Side-to-move static eval, VALUE_NONE when in check
+	Move currentMove;             // Move being searched from this node; Move() for a null move
+	Move excludedMove;            // Move skipped by a singular verification search
+	int moveCount;                // Moves searched so far at this node
+	int doubleExtensions;         // Double singular extensions on the path to the current move
+	int badQuietCount;            // Quiet moves tried without a cutoff, penalised on a later cutoff
+	Move badQuiets[MAX_MOVES];
+};
+
+inline constexpr int SEARCH_STACK_OFFSET = 4; // Sentinel entries before the root ply
+
+// Everything a single Lazy SMP worker mutates during search. Only the
+// transposition table is shared between threads.
+struct SearchThread {
+	int id = 0;                              // 0 = main thread (prints info, owns the clock)
+	Board board;                             // Private copy of the root position
+	SearchHistory history;                   // Killers + history heuristic
+	EvalTables evalTables;                   // Pawn and material caches for the evaluation
+	EvalCache evalCache;                     // Static evals by position hash
+	std::vector<uint64_t> positionHistory;   // Hashes for repetition detection
+	std::atomic<long long> nodes{0};         // Visited node counter
+	PVTable pvTable;                         // Principal variation of the current iteration
+	SearchStack stack[MAX_PLY + SEARCH_STACK_OFFSET + 1]; // Indexed through stack_at(ply)
+
+	SearchStack* stack_at(int ply) { return &stack[ply + SEARCH_STACK_OFFSET]; }
+
+	// Result of the last fully completed iteration
+	Move bestMove;
+	int bestScore = 0;
+	int completedDepth = 0;
+	std::vector<Move> pv;
+};
+
 const SearchParams& get_search_params();
 void set_search_params(const SearchParams& params);
 
+// Number of Lazy SMP threads (main thread included) used by getBestMove.
+void set_thread_count(int count);
+int get_thread_count();
+
 void resetNodeCounter();
-long long getNodeCounter();
+long long getNodeCounter(); // Sum over all search threads
 
 // Move ordering
-int scoreMove(const Board& board, const Move& move, int ply, const Move* ttMove);
+int scoreMove(const Board& board, const SearchHistory& history, const Move& move, int ply, const Move* ttMove);
 
 // Search functions (PV enabled)
-int quiescence(Board& board, int alpha, int beta, int ply);
-int negamax(Board& board, int depth, int alpha, int beta, int ply, std::vector<uint64_t>& positionHistory, std::vector<Move>& pvLine);
+// depth is 0 at the first quiescence ply and decreases below it (quiet checks only at 0)
+int quiescence(SearchThread& td, int alpha, int beta, int ply, int depth = 0);
+int negamax(SearchThread& td, int depth, int alpha, int beta, int ply);
 
 // movetimeMs > 0: time-limited, effectively unlimited depth (search until time runs out).
 // movetimeMs <= 0: depth-limited, no time limit.
@@ -49,7 +106,13 @@ Move getBestMove(Board& board, int maxDepth, int movetimeMs = -1, const std::vec
 // Safe to call even if no search is running.
 void request_stop_search();
 void set_use_tt(bool enabled);
+void set_search_output(bool enabled); // Silence "info" lines (self-play data generation)
+int last_search_score();              // Side-to-move score of the last search (0 if it was not searched)
 void clear_search_heuristics();
+void clear_eval_caches(); // Call after the evaluator changes (e.g. a new EvalFile)
+// Lazy-evaluation counters summed over all search threads (see EvalStats).
+void get_eval_stats(uint64_t& lazyCalls, uint64_t& lazyExits);
+void reset_eval_stats();
 
 
 #endif
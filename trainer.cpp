@@ -0,0 +1,434 @@
+// Offline NNUE tooling, built separately with `make trainer`:
+//
+//   trainer datagen --out data.txt [--games 100] [--depth 8] [--random-plies 8] [--hash 16] [--seed N]
+//   trainer train --data data.txt --out net.nnue [--epochs 10] [--threads 4] [--batch 16384]
+//                 [--lr 0.001] [--wdl 0.5]
+//
+// Training data is plain text, one position per line:
+//   <fen> | <score in centipawns, white POV> | <game result, white POV: 1.0 / 0.5 / 0.0>
+// datagen writes exactly this from self-play; any other source can be converted to it.
+// Positions are parsed with Board::loadFromFEN and mapped to inputs with
+// nnue_feature_index, so the trainer cannot drift from the engine's feature layout.
+
+#include "board.h"
+#include "bitboard.h"
+#include "search.h"
+#include "evaluation.h"
+#include "nnue.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Options = std::map<std::string, std::string>;
+
+std::string opt_str(const Options& opts, const std::string& key, const std::string& fallback) {
+    auto it = opts.find(key);
+    return it == opts.end() ? fallback : it->second;
+}
+
+long long opt_int(const Options& opts, const std::string& key, long long fallback) {
+    auto it = opts.find(key);
+    return it == opts.end() ? fallback : std::atoll(it->second.c_str());
+}
+
+double opt_float(const Options& opts, const std::string& key, double fallback) {
+    auto it = opts.find(key);
+    return it == opts.end() ? fallback : std::atof(it->second.c_str());
+}
+
+bool side_in_check(const Board& board) {
+    int row, col;
+    if (!king_square(board, board.isWhiteTurn, row, col)) return false;
+    return is_square_attacked(board, row, col, !board.isWhiteTurn);
+}
+
+// ---- Self-play data generation ----
+
+constexpr int MAX_GAME_PLIES = 400;
+
+int run_datagen(const Options& opts) {
+    const std::string path = opt_str(opts, "out", "");
+    if (path.empty()) {
+        std::cerr << "datagen: --out <file> is required" << std::endl;
+        return 1;
+    }
+    const long long games = opt_int(opts, "games", 100);
+    const int depth = static_cast<int>(opt_int(opts, "depth", 8));
+    const int randomPlies = static_cast<int>(opt_int(opts, "random-plies", 8));
+    const uint64_t seed = static_cast<uint64_t>(
+        opt_int(opts, "seed", std::chrono::steady_clock::now().time_since_epoch().count()));
+
+    std::ofstream out(path, std::ios::app); // Append so several runs can share one file
+    if (!out) {
+        std::cerr << "datagen: cannot open " << path << std::endl;
+        return 1;
+    }
+
+    // One search thread per process; run several processes with different seeds to scale.
+    set_search_output(false);
+    set_thread_count(1);
+    globalTT.resize(static_cast<size_t>(opt_int(opts, "hash", 16)));
+
+    std::mt19937_64 rng(seed);
+    Board board;
+    std::vector<uint64_t> history;
+    std::vector<std::string> fens;
+    std::vector<int> scores;
+    long long played = 0, positions = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    while (played < games) {
+        globalTT.clear(1);
+        clear_search_heuristics();
+        board.resetBoard();
+        history.assign(1, board.currentHash);
+        fens.clear();
+        scores.clear();
+
+        // Random opening for variety; restart if it stumbles into a finished game.
+        bool opened = true;
+        for (int i = 0; i < randomPlies && opened; i++) {
+            MoveList moves;
+            get_all_moves(board, moves);
+            if (moves.empty()) {
+                opened = false;
+                break;
+            }
+            board.makeMove(moves[static_cast<int>(rng() % moves.size())]);
+            history.push_back(board.currentHash);
+        }
+        if (!opened) continue;
+
+        double result = 0.5;
+        for (int ply = randomPlies; ; ply++) {
+            MoveList moves;
+            get_all_moves(board, moves);
+            const bool inCheck = side_in_check(board);
+            if (moves.empty()) {
+                result = inCheck ? (board.isWhiteTurn ? 0.0 : 1.0) : 0.5;
+                break;
+            }
+            if (ply >= MAX_GAME_PLIES || is_fifty_move_draw(board) ||
+                is_insufficient_material(board) || is_threefold_repetition(history)) {
+                break;
+            }
+
+            Move best = getBestMove(board, depth, -1, history, 0);
+            int score = last_search_score();
+            if (std::abs(score) >= MATE_SCORE - 1000) {
+                result = ((score > 0) == board.isWhiteTurn) ? 1.0 : 0.0;
+                break;
+            }
+            // Quiet, unforced positions only: the static eval cannot see pending tactics.
+            if (moves.size() > 1 && !inCheck && is_quiet(board, best)) {
+                fens.push_back(board_to_fen(board, 1 + ply / 2));
+                scores.push_back(board.isWhiteTurn ? score : -score);
+            }
+            board.makeMove(best);
+            history.push_back(board.currentHash);
+        }
+
+        const char* resultStr = result == 1.0 ? "1.0" : (result == 0.0 ? "0.0" : "0.5");
+        for (size_t i = 0; i < fens.size(); i++) {
+            out << fens[i] << " | " << scores[i] << " | " << resultStr << '\n';
+        }
+        positions += static_cast<long long>(fens.size());
+        played++;
+
+        if (played % 10 == 0 || played == games) {
+            out.flush();
+            long long secs = std::chrono::duration_cast<std::chrono::seconds>(
+                std::chrono::steady_clock::now() - start).count();
+            std::cout << "games " << played << " positions " << positions
+                      << " time " << secs << "s" << std::endl;
+        }
+    }
+    return 0;
+}
+
+// ---- Training ----
+
+constexpr int MAX_PIECES = 32;
+
+struct TrainingPosition {
+    uint8_t pieceCount;
+    uint8_t stm;
+    int16_t score;  // Side-to-move POV, centipawns
+    float result;   // Side-to-move POV, 1 / 0.5 / 0
+    uint8_t piece[MAX_PIECES];
+    uint8_t sq[MAX_PIECES];
+};
+
+bool parse_position(Board& board, const std::string& line, TrainingPosition& pos) {
+    size_t bar1 = line.find('|');
+    size_t bar2 = bar1 == std::string::npos ? bar1 : line.find('|', bar1 + 1);
+    if (bar2 == std::string::npos) return false;
+
+    board.loadFromFEN(line.substr(0, bar1));
+    int score = std::atoi(line.c_str() + bar1 + 1);
+    double result = std::atof(line.c_str() + bar2 + 1);
+
+    Bitboard occ = board.color[WHITE] | board.color[BLACK];
+    if (popcount(occ) > MAX_PIECES) return false;
+    pos.pieceCount = 0;
+    while (occ) {
+        int sq = lsb(occ);
+        occ &= occ - 1;
+        pos.piece[pos.pieceCount] = static_cast<uint8_t>(board.mailbox[sq]);
+        pos.sq[pos.pieceCount++] = static_cast<uint8_t>(sq);
+    }
+    pos.stm = static_cast<uint8_t>(side_to_move(board));
+    score = std::clamp(score, -4000, 4000);
+    pos.score = static_cast<int16_t>(pos.stm == WHITE ? score : -score);
+    pos.result = static_cast<float>(pos.stm == WHITE ? result : 1.0 - result);
+    return true;
+}
+
+// Float model with the same shape as the engine network, stored flat so the
+// optimiser and the gradient reduction are single loops.
+constexpr int H = NNUE_HIDDEN;
+constexpr size_t W1_OFF = 0;
+constexpr size_t B1_OFF = W1_OFF + size_t(NNUE_INPUTS) * H;
+constexpr size_t W2_OFF = B1_OFF + H;
+constexpr size_t B2_OFF = W2_OFF + 2 * H;
+constexpr size_t PARAM_COUNT = B2_OFF + 1;
+
+// Keeps every quantised weight within int16 with headroom: 32 pieces plus the bias
+// at 1.98 * NNUE_QA each cannot overflow the accumulator.
+constexpr float WEIGHT_CLIP = 1.98f;
+constexpr float WDL_SCALE = 400.0f; // Centipawns per sigmoid unit in the target
+
+inline float sigmoid(float x) { return 1.0f / (1.0f + std::exp(-x)); }
+
+// Forward and backward pass for one position; accumulates into grad and returns the loss.
+float train_position(const float* params, const TrainingPosition& pos, float wdl, float* grad) {
+    const float* w1 = params + W1_OFF;
+    const float* b1 = params + B1_OFF;
+    const float* w2 = params + W2_OFF;
+
+    // Perspective 0 is the side to move, as in nnue_evaluate.
+    int features[2][MAX_PIECES];
+    float acc[2][H];
+    for (int s = 0; s < 2; s++) {
+        const int persp = s == 0 ? pos.stm : pos.stm ^ 1;
+        std::memcpy(acc[s], b1, sizeof(acc[s]));
+        for (int i = 0; i < pos.pieceCount; i++) {
+            features[s][i] = nnue_feature_index(persp, pos.piece[i], pos.sq[i]);
+            const float* row = w1 + size_t(features[s][i]) * H;
+            for (int j = 0; j < H; j++) acc[s][j] += row[j];
+        }
+    }
+
+    float out = params[B2_OFF];
+    for (int s = 0; s < 2; s++) {
+        for (int j = 0; j < H; j++) out += std::clamp(acc[s][j], 0.0f, 1.0f) * w2[s * H + j];
+    }
+
+    const float k = NNUE_SCALE / WDL_SCALE;
+    const float pred = sigmoid(out * k);
+    const float target = wdl * pos.result + (1.0f - wdl) * sigmoid(pos.score / WDL_SCALE);
+    const float diff = pred - target;
+    const float g = 2.0f * diff * pred * (1.0f - pred) * k;
+
+    grad[B2_OFF] += g;
+    for (int s = 0; s < 2; s++) {
+        float delta[H];
+        for (int j = 0; j < H; j++) {
+            const float a = acc[s][j];
+            grad[W2_OFF + s * H + j] += g * std::clamp(a, 0.0f, 1.0f);
+            delta[j] = (a > 0.0f && a < 1.0f) ? g * w2[s * H + j] : 0.0f;
+            grad[B1_OFF + j] += delta[j];
+        }
+        for (int i = 0; i < pos.pieceCount; i++) {
+            float* row = grad + W1_OFF + size_t(features[s][i]) * H;
+            for (int j = 0; j < H; j++) row[j] += delta[j];
+        }
+    }
+    return diff * diff;
+}
+
+template <typename T>
+void write_array(std::ofstream& out, const T* data, size_t count) {
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+}
+
+int16_t quantize16(float v, int scale) {
+    return static_cast<int16_t>(std::lround(std::clamp(v * scale, -32767.0f, 32767.0f)));
+}
+
+// Writes the float model in the quantised format nnue_load reads.
+bool export_network(const std::vector<float>& params, const std::string& path) {
+    std::vector<int16_t> w1(size_t(NNUE_INPUTS) * H), b1(H), w2(2 * H);
+    for (size_t i = 0; i < w1.size(); i++) w1[i] = quantize16(params[W1_OFF + i], NNUE_QA);
+    for (int i = 0; i < H; i++) b1[i] = quantize16(params[B1_OFF + i], NNUE_QA);
+    for (int i = 0; i < 2 * H; i++) w2[i] = quantize16(params[W2_OFF + i], NNUE_QB);
+    int32_t b2 = static_cast<int32_t>(std::lround(params[B2_OFF] * NNUE_QA * NNUE_QB));
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    const uint32_t version = NNUE_VERSION, hidden = NNUE_HIDDEN;
+    out.write(NNUE_MAGIC, sizeof(NNUE_MAGIC));
+    write_array(out, &version, 1);
+    write_array(out, &hidden, 1);
+    write_array(out, w1.data(), w1.size());
+    write_array(out, b1.data(), b1.size());
+    write_array(out, w2.data(), w2.size());
+    write_array(out, &b2, 1);
+    return static_cast<bool>(out);
+}
+
+int run_train(const Options& opts) {
+    const std::string dataPath = opt_str(opts, "data", "");
+    const std::string outPath = opt_str(opts, "out", "");
+    if (dataPath.empty() || outPath.empty()) {
+        std::cerr << "train: --data <file> and --out <file> are required" << std::endl;
+        return 1;
+    }
+    const int epochs = static_cast<int>(opt_int(opts, "epochs", 10));
+    const int threads = std::clamp(static_cast<int>(opt_int(opts, "threads", 4)), 1, 256);
+    const size_t batchSize = static_cast<size_t>(std::max(1LL, opt_int(opts, "batch", 16384)));
+    const float lr = static_cast<float>(opt_float(opts, "lr", 0.001));
+    const float wdl = static_cast<float>(std::clamp(opt_float(opts, "wdl", 0.5), 0.0, 1.0));
+
+    std::ifstream in(dataPath);
+    if (!in) {
+        std::cerr << "train: cannot open " << dataPath << std::endl;
+        return 1;
+    }
+    std::vector<TrainingPosition> data;
+    Board board;
+    std::string line;
+    long long skipped = 0;
+    while (std::getline(in, line)) {
+        if (line.empty()) continue;
+        TrainingPosition pos;
+        if (parse_position(board, line, pos)) data.push_back(pos);
+        else skipped++;
+    }
+    std::cout << "loaded " << data.size() << " positions (" << skipped << " skipped)" << std::endl;
+    if (data.empty()) return 1;
+
+    std::mt19937 rng(12345);
+    std::vector<float> params(PARAM_COUNT);
+    {
+        std::uniform_real_distribution<float> w1Init(-0.15f, 0.15f);
+        std::uniform_real_distribution<float> w2Init(-0.05f, 0.05f);
+        for (size_t i = W1_OFF; i < B1_OFF; i++) params[i] = w1Init(rng);
+        for (size_t i = B1_OFF; i < W2_OFF; i++) params[i] = 0.1f;
+        for (size_t i = W2_OFF; i < B2_OFF; i++) params[i] = w2Init(rng);
+    }
+
+    // Adam state
+    constexpr float BETA1 = 0.9f, BETA2 = 0.999f, EPS = 1e-8f;
+    std::vector<float> m(PARAM_COUNT, 0.0f), v(PARAM_COUNT, 0.0f), grad(PARAM_COUNT);
+    std::vector<std::vector<float>> threadGrad(threads, std::vector<float>(PARAM_COUNT));
+    std::vector<double> threadLoss(threads);
+    std::vector<size_t> order(data.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    long long step = 0;
+
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        auto start = std::chrono::steady_clock::now();
+        std::shuffle(order.begin(), order.end(), rng);
+        double epochLoss = 0.0;
+
+        for (size_t begin = 0; begin < order.size(); begin += batchSize) {
+            const size_t end = std::min(order.size(), begin + batchSize);
+
+            // Each thread accumulates a private gradient over its slice of the batch.
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; t++) {
+                workers.emplace_back([&, t]() {
+                    std::vector<float>& g = threadGrad[t];
+                    std::fill(g.begin(), g.end(), 0.0f);
+                    double loss = 0.0;
+                    for (size_t i = begin + t; i < end; i += threads) {
+                        loss += train_position(params.data(), data[order[i]], wdl, g.data());
+                    }
+                    threadLoss[t] = loss;
+                });
+            }
+            for (std::thread& w : workers) w.join();
+
+            const float invBatch = 1.0f / static_cast<float>(end - begin);
+            grad = threadGrad[0];
+            for (int t = 1; t < threads; t++) {
+                const std::vector<float>& g = threadGrad[t];
+                for (size_t i = 0; i < PARAM_COUNT; i++) grad[i] += g[i];
+            }
+            for (int t = 0; t < threads; t++) epochLoss += threadLoss[t];
+
+            step++;
+            const float corr1 = 1.0f - std::pow(BETA1, static_cast<float>(step));
+            const float corr2 = 1.0f - std::pow(BETA2, static_cast<float>(step));
+            for (size_t i = 0; i < PARAM_COUNT; i++) {
+                const float gi = grad[i] * invBatch;
+                m[i] = BETA1 * m[i] + (1.0f - BETA1) * gi;
+                v[i] = BETA2 * v[i] + (1.0f - BETA2) * gi * gi;
+                const float update = lr * (m[i] / corr1) / (std::sqrt(v[i] / corr2) + EPS);
+                params[i] = std::clamp(params[i] - update, -WEIGHT_CLIP, WEIGHT_CLIP);
+            }
+        }
+
+        long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        std::cout << "epoch " << epoch << " loss " << epochLoss / static_cast<double>(data.size())
+                  << " time " << ms << "ms" << std::endl;
+
+        // Checkpoint every epoch so an interrupted run still leaves a usable net.
+        if (!export_network(params, outPath)) {
+            std::cerr << "train: cannot write " << outPath << std::endl;
+            return 1;
+        }
+    }
+    std::cout << "wrote " << outPath << std::endl;
+    return 0;
+}
+
+void print_usage() {
+    std::cout << "usage:\n"
+              << "  trainer datagen --out data.txt [--games 100] [--depth 8] [--random-plies 8] [--hash 16] [--seed N]\n"
+              << "  trainer train --data data.txt --out net.nnue [--epochs 10] [--threads 4] [--batch 16384]"
+                 " [--lr 0.001] [--wdl 0.5]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::cout.setf(std::ios::unitbuf);
+    init_all();
+    init_eval_tables();
+    initLMRtables();
+
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+    Options opts;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (key.rfind("--", 0) != 0) {
+            print_usage();
+            return 1;
+        }
+        opts[key.substr(2)] = argv[i + 1];
+    }
+
+    const std::string mode = argv[1];
+    if (mode == "datagen") return run_datagen(opts);
+    if (mode == "train") return run_train(opts);
+    print_usage();
+    return 1;
+}
@@ -0,0 +1,459 @@
+// Texel tuner for the classic evaluation, built separately with `make tuner`:
+//
+//   tuner --data positions.txt [--out tuned.txt] [--epochs 2000] [--threads 4] [--lr 1.0] [--k 0]
+//
+// Each line holds a position and its game result, white POV, either in the trainer's
+// format (`<fen> | <score> | <1.0 / 0.5 / 0.0>`) or as an EPD with the result in brackets
+// or quotes (`... [1.0]`, `... [0-1]`, `... c9 "1/2-1/2";`).
+//
+// The tuned weights are the piece values, the PeSTO tables and the mobility tables. The
+// eval is linear in them for a fixed position, so every position is reduced once to a
+// sparse coefficient trace plus the terms that stay fixed (pawns, imbalance, phase and
+// endgame scale, read through classic_eval_terms). Training then never calls the
+// evaluation: it fits K first, then runs full-batch Adam on
+//   mean (result - sigmoid(K * eval / 400))^2
+// and writes the weights as C++ tables to paste into evaluation.cpp.
+
+#include "board.h"
+#include "bitboard.h"
+#include "attacks.h"
+#include "evaluation.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Options = std::map<std::string, std::string>;
+
+std::string opt_str(const Options& opts, const std::string& key, const std::string& fallback) {
+    auto it = opts.find(key);
+    return it == opts.end() ? fallback : it->second;
+}
+
+double opt_float(const Options& opts, const std::string& key, double fallback) {
+    auto it = opts.find(key);
+    return it == opts.end() ? fallback : std::atof(it->second.c_str());
+}
+
+// ---- Parameter layout ----
+// Tapered parameters have an mg and an eg weight; mobility is added after tapering in
+// the engine, so its parameters are flat (one weight for both phases).
+
+constexpr int MATERIAL_OFF = 0;                      // [piece type - 1], pawn..queen
+constexpr int PSQT_OFF = MATERIAL_OFF + 5;           // [piece type - 1][A8..H1 square]
+constexpr int TAPERED_COUNT = PSQT_OFF + 6 * 64;
+
+constexpr int MOBILITY_SIZE[4] = {9, 14, 15, 28};    // Knight, bishop, rook, queen
+constexpr int MOBILITY_OFF[4] = {0, 9, 23, 38};
+constexpr int FLAT_COUNT = 66;
+
+// Flat vector: [0, TAPERED_COUNT) mg, then eg, then the flat parameters.
+constexpr int PARAM_COUNT = 2 * TAPERED_COUNT + FLAT_COUNT;
+constexpr int EG_OFF = TAPERED_COUNT;
+constexpr int FLAT_OFF = 2 * TAPERED_COUNT;
+
+std::vector<double> initial_params() {
+    std::vector<double> p(PARAM_COUNT);
+    for (int pt = 0; pt < 5; pt++) {
+        p[MATERIAL_OFF + pt] = mg_value[pt];
+        p[EG_OFF + MATERIAL_OFF + pt] = eg_value[pt];
+    }
+    for (int pt = 0; pt < 6; pt++) {
+        for (int sq = 0; sq < 64; sq++) {
+            p[PSQT_OFF + pt * 64 + sq] = mg_pesto_tables[pt][sq];
+            p[EG_OFF + PSQT_OFF + pt * 64 + sq] = eg_pesto_tables[pt][sq];
+        }
+    }
+    const int* mobility[4] = {KnightMobility, BishopMobility, RookMobility, QueenMobility};
+    for (int t = 0; t < 4; t++) {
+        for (int i = 0; i < MOBILITY_SIZE[t]; i++) p[FLAT_OFF + MOBILITY_OFF[t] + i] = mobility[t][i];
+    }
+    return p;
+}
+
+// ---- Traces ----
+
+struct TraceTerm {
+    uint16_t index;  // Tapered parameter, or TAPERED_COUNT + flat parameter
+    int16_t coeff;   // White count minus black count
+};
+
+struct TracedPosition {
+    uint32_t begin, end;  // Range in the shared term array
+    float result;         // White POV
+    int16_t fixedMg, fixedEg;
+    uint8_t phase;
+    uint8_t scale[2];
+};
+
+struct Dataset {
+    std::vector<TracedPosition> positions;
+    std::vector<TraceTerm> terms;
+};
+
+// Game result, white POV, from the text after the FEN; negative when there is none.
+double parse_result(const std::string& label) {
+    if (label.find("1/2") != std::string::npos || label.find("0.5") != std::string::npos) return 0.5;
+    if (label.find("1-0") != std::string::npos || label.find("1.0") != std::string::npos) return 1.0;
+    if (label.find("0-1") != std::string::npos || label.find("0.0") != std::string::npos) return 0.0;
+    return -1.0;
+}
+
+bool split_line(const std::string& line, std::string& fen, double& result) {
+    const size_t bar1 = line.find('|');
+    if (bar1 != std::string::npos) {
+        const size_t bar2 = line.find('|', bar1 + 1);
+        if (bar2 == std::string::npos) return false;
+        fen = line.substr(0, bar1);
+        result = std::atof(line.c_str() + bar2 + 1);
+        return true;
+    }
+    size_t label = line.find_first_of("[\"");
+    if (label == std::string::npos) return false;
+    result = parse_result(line.substr(label));
+    if (result < 0.0) return false;
+    fen = line.substr(0, label);
+    const size_t c9 = fen.find(" c9");
+    if (c9 != std::string::npos) fen.resize(c9);
+    return true;
+}
+
+// Appends the trace of `board`; false for positions the tuner cannot use.
+bool trace_position(const Board& board, EvalTables& tables, double result, Dataset& data) {
+    ClassicEvalTerms fixed;
+    if (!classic_eval_terms(board, tables, fixed)) return false;
+
+    int coeffs[TAPERED_COUNT + FLAT_COUNT] = {}; // Tapered then flat, dense while building
+    Bitboard occ = board.color[WHITE] | board.color[BLACK];
+    while (occ) {
+        const int sq = lsb(occ);
+        occ &= occ - 1;
+        const int piece = board.mailbox[sq];
+        const int pt = piece_type(piece) - 1;
+        const bool white = piece_color(piece) == WHITE;
+        const int sign = white ? 1 : -1;
+        if (pt < 5) coeffs[MATERIAL_OFF + pt] += sign;
+        coeffs[PSQT_OFF + pt * 64 + (white ? (sq ^ 56) : sq)] += sign;
+    }
+
+    AttackMaps maps;
+    compute_attack_maps(board, maps);
+    for (int c = WHITE; c <= BLACK; c++) {
+        const int sign = c == WHITE ? 1 : -1;
+        const Bitboard notOwn = ~board.color[c];
+        for (int t = 0; t < 4; t++) {
+            const int type = KNIGHT + t;
+            for (int k = 0; k < maps.count[c][type]; k++) {
+                const int mobility = popcount(maps.pieces[c][type][k] & notOwn);
+                coeffs[TAPERED_COUNT + MOBILITY_OFF[t] + mobility] += sign;
+            }
+        }
+    }
+
+    TracedPosition pos;
+    pos.begin = static_cast<uint32_t>(data.terms.size());
+    for (int i = 0; i < TAPERED_COUNT + FLAT_COUNT; i++) {
+        if (coeffs[i]) data.terms.push_back({static_cast<uint16_t>(i), static_cast<int16_t>(coeffs[i])});
+    }
+    pos.end = static_cast<uint32_t>(data.terms.size());
+    pos.result = static_cast<float>(result);
+    pos.fixedMg = static_cast<int16_t>(score_mg(fixed.fixed));
+    pos.fixedEg = static_cast<int16_t>(score_eg(fixed.fixed));
+    pos.phase = static_cast<uint8_t>(fixed.phase);
+    pos.scale[WHITE] = static_cast<uint8_t>(fixed.scale[WHITE]);
+    pos.scale[BLACK] = static_cast<uint8_t>(fixed.scale[BLACK]);
+    data.positions.push_back(pos);
+    return true;
+}
+
+// ---- Model ----
+
+struct EvalParts {
+    double mg, eg, flat;
+    double scale;  // Applied endgame scale, 0..1
+};
+
+EvalParts trace_parts(const std::vector<double>& params, const Dataset& data, const TracedPosition& pos) {
+    EvalParts e{static_cast<double>(pos.fixedMg), static_cast<double>(pos.fixedEg), 0.0, 1.0};
+    for (uint32_t i = pos.begin; i < pos.end; i++) {
+        const TraceTerm& t = data.terms[i];
+        if (t.index < TAPERED_COUNT) {
+            e.mg += t.coeff * params[t.index];
+            e.eg += t.coeff * params[EG_OFF + t.index];
+        } else {
+            e.flat += t.coeff * params[FLAT_OFF + t.index - TAPERED_COUNT];
+        }
+    }
+    e.scale = pos.scale[e.eg > 0 ? WHITE : BLACK] / static_cast<double>(SCALE_NORMAL);
+    return e;
+}
+
+// White POV, same shape as evaluate_classic
+double trace_eval(const EvalParts& e, const TracedPosition& pos) {
+    return (e.mg * pos.phase + e.eg * e.scale * (24 - pos.phase)) / 24.0 + e.flat;
+}
+
+double sigmoid(double k, double eval) {
+    return 1.0 / (1.0 + std::pow(10.0, -k * eval / 400.0));
+}
+
+// Runs fn(begin, end, thread) over slices of the positions and waits for all of them.
+template <typename Fn>
+void parallel_for(size_t count, int threads, Fn&& fn) {
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        const size_t begin = count * t / threads;
+        const size_t end = count * (t + 1) / threads;
+        workers.emplace_back([&fn, begin, end, t]() { fn(begin, end, t); });
+    }
+    for (std::thread& w : workers) w.join();
+}
+
+double mean_error(const std::vector<double>& params, const Dataset& data, double k, int threads) {
+    std::vector<double> sums(threads);
+    parallel_for(data.positions.size(), threads, [&](size_t begin, size_t end, int t) {
+        double sum = 0.0;
+        for (size_t i = begin; i < end; i++) {
+            const TracedPosition& pos = data.positions[i];
+            const double err = pos.result - sigmoid(k, trace_eval(trace_parts(params, data, pos), pos));
+            sum += err * err;
+        }
+        sums[t] = sum;
+    });
+    double total = 0.0;
+    for (double s : sums) total += s;
+    return total / static_cast<double>(data.positions.size());
+}
+
+// Golden-section search for the K that best maps the current eval to results.
+double fit_k(const std::vector<double>& params, const Dataset& data, int threads) {
+    const double phi = (std::sqrt(5.0) - 1.0) / 2.0;
+    double lo = 0.1, hi = 4.0;
+    double a = hi - phi * (hi - lo), b = lo + phi * (hi - lo);
+    double ea = mean_error(params, data, a, threads), eb = mean_error(params, data, b, threads);
+    for (int i = 0; i < 40; i++) {
+        if (ea < eb) {
+            hi = b;
+            b = a;
+            eb = ea;
+            a = hi - phi * (hi - lo);
+            ea = mean_error(params, data, a, threads);
+        } else {
+            lo = a;
+            a = b;
+            ea = eb;
+            b = lo + phi * (hi - lo);
+            eb = mean_error(params, data, b, threads);
+        }
+    }
+    return (lo + hi) / 2.0;
+}
+
+// Gradient of the summed squared error; returns the summed error.
+double accumulate_gradient(const std::vector<double>& params, const Dataset& data, double k,
+                           size_t begin, size_t end, std::vector<double>& grad) {
+    const double dSigma = k * std::log(10.0) / 400.0;
+    double errorSum = 0.0;
+    for (size_t i = begin; i < end; i++) {
+        const TracedPosition& pos = data.positions[i];
+        const EvalParts e = trace_parts(params, data, pos);
+        const double s = sigmoid(k, trace_eval(e, pos));
+        const double err = pos.result - s;
+        errorSum += err * err;
+
+        const double dEval = -2.0 * err * s * (1.0 - s) * dSigma;
+        const double dMg = dEval * pos.phase / 24.0;
+        const double dEg = dEval * e.scale * (24 - pos.phase) / 24.0;
+        for (uint32_t j = pos.begin; j < pos.end; j++) {
+            const TraceTerm& t = data.terms[j];
+            if (t.index < TAPERED_COUNT) {
+                grad[t.index] += dMg * t.coeff;
+                grad[EG_OFF + t.index] += dEg * t.coeff;
+            } else {
+                grad[FLAT_OFF + t.index - TAPERED_COUNT] += dEval * t.coeff;
+            }
+        }
+    }
+    return errorSum;
+}
+
+// ---- Output ----
+
+void print_values(std::ostream& out, const char* name, const std::vector<double>& p, int off) {
+    out << "const int " << name << "[6] = { ";
+    for (int pt = 0; pt < 5; pt++) out << std::lround(p[off + MATERIAL_OFF + pt]) << ", ";
+    out << "0 };\n";
+}
+
+void print_table(std::ostream& out, const char* name, const std::vector<double>& p, int off) {
+    out << "const int " << name << "[64] = {\n";
+    for (int r = 0; r < 8; r++) {
+        out << "   ";
+        for (int f = 0; f < 8; f++) {
+            out << std::setw(5) << std::lround(p[off + r * 8 + f]) << (r * 8 + f < 63 ? "," : "");
+        }
+        out << "\n";
+    }
+    out << "};\n\n";
+}
+
+void print_mobility(std::ostream& out, const char* name, const std::vector<double>& p, int t) {
+    out << "const int " << name << "[" << MOBILITY_SIZE[t] << "] = { ";
+    for (int i = 0; i < MOBILITY_SIZE[t]; i++) {
+        out << std::lround(p[FLAT_OFF + MOBILITY_OFF[t] + i]) << (i + 1 < MOBILITY_SIZE[t] ? ", " : " ");
+    }
+    out << "};\n";
+}
+
+bool write_tables(const std::vector<double>& p, const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+    static const char* names[6] = {"pawn", "knight", "bishop", "rook", "queen", "king"};
+    print_values(out, "mg_value", p, 0);
+    print_values(out, "eg_value", p, EG_OFF);
+    out << "\n";
+    print_mobility(out, "KnightMobility", p, 0);
+    print_mobility(out, "BishopMobility", p, 1);
+    print_mobility(out, "RookMobility", p, 2);
+    print_mobility(out, "QueenMobility", p, 3);
+    out << "\n";
+    for (int pt = 0; pt < 6; pt++) {
+        print_table(out, ("mg_" + std::string(names[pt]) + "_table").c_str(), p, PSQT_OFF + pt * 64);
+        print_table(out, ("eg_" + std::string(names[pt]) + "_table").c_str(), p, EG_OFF + PSQT_OFF + pt * 64);
+    }
+    return static_cast<bool>(out);
+}
+
+// ---- Driver ----
+
+int run_tune(const Options& opts) {
+    const std::string dataPath = opt_str(opts, "data", "");
+    const std::string outPath = opt_str(opts, "out", "tuned.txt");
+    if (dataPath.empty()) {
+        std::cerr << "tune: --data is required" << std::endl;
+        return 1;
+    }
+    const int epochs = std::max(1, static_cast<int>(opt_float(opts, "epochs", 2000)));
+    const int threads = std::clamp(static_cast<int>(opt_float(opts, "threads", 4)), 1, 256);
+    const double lr = opt_float(opts, "lr", 1.0);
+
+    std::ifstream in(dataPath);
+    if (!in) {
+        std::cerr << "tune: cannot open " << dataPath << std::endl;
+        return 1;
+    }
+    Dataset data;
+    Board board;
+    EvalTables tables;
+    std::string line, fen;
+    long long skipped = 0;
+    int maxDiff = 0;
+    const std::vector<double> start = initial_params();
+    while (std::getline(in, line)) {
+        double result;
+        if (line.empty() || !split_line(line, fen, result)) {
+            skipped++;
+            continue;
+        }
+        board.loadFromFEN(fen);
+        if (!trace_position(board, tables, result, data)) {
+            skipped++;
+            continue;
+        }
+        // The trace must reproduce the engine's classic eval (up to integer rounding)
+        if (data.positions.size() <= 10000) {
+            const TracedPosition& pos = data.positions.back();
+            const int traced = static_cast<int>(std::lround(trace_eval(trace_parts(start, data, pos), pos)));
+            const int engine = evaluate_board_pesto(board, tables) * (board.isWhiteTurn ? 1 : -1);
+            maxDiff = std::max(maxDiff, std::abs(traced - engine));
+        }
+    }
+    std::cout << "loaded " << data.positions.size() << " positions (" << skipped << " skipped), "
+              << data.terms.size() << " trace terms; trace vs engine eval max diff " << maxDiff << " cp"
+              << std::endl;
+    if (data.positions.empty()) return 1;
+
+    std::vector<double> params = start;
+    double k = opt_float(opts, "k", 0.0);
+    if (k <= 0.0) k = fit_k(params, data, threads);
+    std::cout << "K " << k << " error " << mean_error(params, data, k, threads) << std::endl;
+
+    constexpr double BETA1 = 0.9, BETA2 = 0.999, EPS = 1e-8;
+    std::vector<double> m(PARAM_COUNT, 0.0), v(PARAM_COUNT, 0.0);
+    std::vector<std::vector<double>> threadGrad(threads, std::vector<double>(PARAM_COUNT));
+    std::vector<double> threadError(threads);
+    const double invCount = 1.0 / static_cast<double>(data.positions.size());
+    auto start_time = std::chrono::steady_clock::now();
+
+    for (int epoch = 1; epoch <= epochs; epoch++) {
+        parallel_for(data.positions.size(), threads, [&](size_t begin, size_t end, int t) {
+            std::vector<double>& g = threadGrad[t];
+            std::fill(g.begin(), g.end(), 0.0);
+            threadError[t] = accumulate_gradient(params, data, k, begin, end, g);
+        });
+
+        double error = 0.0;
+        for (int t = 0; t < threads; t++) error += threadError[t];
+        const double corr1 = 1.0 - std::pow(BETA1, epoch);
+        const double corr2 = 1.0 - std::pow(BETA2, epoch);
+        for (int i = 0; i < PARAM_COUNT; i++) {
+            double g = 0.0;
+            for (int t = 0; t < threads; t++) g += threadGrad[t][i];
+            g *= invCount;
+            m[i] = BETA1 * m[i] + (1.0 - BETA1) * g;
+            v[i] = BETA2 * v[i] + (1.0 - BETA2) * g * g;
+            params[i] -= lr * (m[i] / corr1) / (std::sqrt(v[i] / corr2) + EPS);
+        }
+
+        if (epoch % 100 == 0 || epoch == epochs) {
+            long long ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start_time).count();
+            std::cout << "epoch " << epoch << " error " << error * invCount << " time " << ms << "ms" << std::endl;
+            // Checkpoint so an interrupted run still leaves usable tables
+            if (!write_tables(params, outPath)) {
+                std::cerr << "tune: cannot write " << outPath << std::endl;
+                return 1;
+            }
+        }
+    }
+    std::cout << "wrote " << outPath << std::endl;
+    return 0;
+}
+
+void print_usage() {
+    std::cout << "usage:\n"
+              << "  tuner --data positions.txt [--out tuned.txt] [--epochs 2000] [--threads 4] [--lr 1.0]"
+                 " [--k 0 (fit)]\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::cout.setf(std::ios::unitbuf);
+    init_all();
+    init_eval_tables();
+
+    Options opts;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        if (key.rfind("--", 0) != 0) {
+            print_usage();
+            return 1;
+        }
+        opts[key.substr(2)] = argv[i + 1];
+    }
+    if (!opts.count("data")) {
+        print_usage();
+        return 1;
+    }
+    return run_tune(opts);
+}